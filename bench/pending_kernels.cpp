@@ -0,0 +1,66 @@
+/**************************************************************
+ *  pending_kernels.cpp  —  scalar vs vectorised pending scans
+ *
+ *  Times the fit search of pending_soa.hpp on a synthetic queue
+ *  where no job fits, so the whole queue is read, with the scalar
+ *  loop, SSE2 and, when available, AVX2.
+ *
+ *      meson compile -C build bench_pending
+ *      ./build/bench_pending [jobs] [rounds]
+ *************************************************************/
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "pending_soa.hpp"
+
+template <class F>
+static double best_ns(int rounds, F f)
+{
+    double best = 1e300;
+    for (int r = 0; r < rounds; ++r) {
+        auto t0 = std::chrono::steady_clock::now();
+        f();
+        auto t1 = std::chrono::steady_clock::now();
+        best = std::min(best, std::chrono::duration<double, std::nano>(t1 - t0).count());
+    }
+    return best;
+}
+
+static volatile size_t sink;
+
+int main(int argc, char** argv)
+{
+    size_t n      = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 50000;
+    int    rounds = argc > 2 ? std::atoi(argv[2]) : 200;
+
+    std::mt19937_64 rng(42);
+    std::uniform_int_distribution<uint32_t> hosts(1, 64);
+    std::uniform_real_distribution<double>  wall(60.0, 86400.0);
+
+    std::vector<uint32_t> h(n);
+    std::vector<double>   w(n);
+    for (size_t i = 0; i < n; ++i) { h[i] = hosts(rng); w[i] = wall(rng); }
+
+    /* 8 free hosts, 30 s to the reservation: nothing fits */
+    const uint32_t free = 8;
+    const double   now = 86400.0, limit = now + 30.0;
+
+    using namespace soa_kernels;
+    printf("%-8s %14s\n", "kernel", "find_fit_ns");
+
+    printf("%-8s %14.0f\n", "scalar",
+           best_ns(rounds, [&]{ sink = find_fit_scalar(h.data(), w.data(), n, 0, free, now, limit); }));
+#ifdef PENDING_SOA_X86
+    printf("%-8s %14.0f\n", "sse2",
+           best_ns(rounds, [&]{ sink = find_fit_sse2(h.data(), w.data(), n, free, now, limit); }));
+    if (has_avx2())
+        printf("%-8s %14.0f\n", "avx2",
+               best_ns(rounds, [&]{ sink = find_fit_avx2(h.data(), w.data(), n, free, now, limit); }));
+#endif
+    return 0;
+}
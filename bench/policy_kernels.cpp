@@ -0,0 +1,119 @@
+/**************************************************************
+ *  policy_kernels.cpp  —  runtime vs compile-time queue keys
+ *
+ *  Sorts the same synthetic pending queue with the comparator
+ *  the plug-in used to run (policy switch in key_for() and the
+ *  threshold tests inside the lambda) and with the comparator of
+ *  the specialised engines (policy and threshold fixed at compile
+ *  time), for every policy with and without threshold.
+ *
+ *      meson compile -C build bench_policies
+ *      ./build/bench_policies [jobs] [rounds]
+ *************************************************************/
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "policies.hpp"
+
+struct Job {
+    uint32_t nb_hosts;
+    double   walltime;
+    double   submit_time;
+    uint64_t seq;
+};
+
+static double threshold_sec = -1.0;
+
+/* the former comparator: everything decided per comparison */
+static void sort_runtime(std::vector<Job*>& q, double now, Policy p)
+{
+    std::stable_sort(q.begin(), q.end(), [&](const Job* a, const Job* b){
+        if (threshold_sec >= 0.0) {
+            bool ao = now - a->submit_time > threshold_sec;
+            bool bo = now - b->submit_time > threshold_sec;
+            if (ao != bo) return ao;
+        }
+        return key_for(a, now, p) < key_for(b, now, p);
+    });
+}
+
+/* the engines' comparator: one instantiation per (policy, threshold) */
+template <Policy P, bool Threshold>
+static void sort_static(std::vector<Job*>& q, double now)
+{
+    std::stable_sort(q.begin(), q.end(), [&](const Job* a, const Job* b){
+        if constexpr (Threshold) {
+            bool ao = now - a->submit_time > threshold_sec;
+            bool bo = now - b->submit_time > threshold_sec;
+            if (ao != bo) return ao;
+        }
+        return policy_key<P>(a, now) < policy_key<P>(b, now);
+    });
+}
+
+template <bool Threshold>
+static void sort_static(std::vector<Job*>& q, double now, Policy p)
+{
+    switch (p) {
+        case Policy::EXP : sort_static<Policy::EXP , Threshold>(q, now); break;
+        case Policy::FCFS: sort_static<Policy::FCFS, Threshold>(q, now); break;
+        case Policy::LCFS: sort_static<Policy::LCFS, Threshold>(q, now); break;
+        case Policy::LPF : sort_static<Policy::LPF , Threshold>(q, now); break;
+        case Policy::LQF : sort_static<Policy::LQF , Threshold>(q, now); break;
+        case Policy::SPF : sort_static<Policy::SPF , Threshold>(q, now); break;
+        case Policy::SQF : sort_static<Policy::SQF , Threshold>(q, now); break;
+    }
+}
+
+template <class F>
+static double time_ns(const std::vector<Job*>& queue, int rounds, F sort)
+{
+    std::vector<Job*> q;
+    double best = 1e300;
+    for (int r = 0; r < rounds; ++r) {
+        q = queue;
+        auto t0 = std::chrono::steady_clock::now();
+        sort(q);
+        auto t1 = std::chrono::steady_clock::now();
+        best = std::min(best, std::chrono::duration<double, std::nano>(t1 - t0).count());
+    }
+    return best;
+}
+
+int main(int argc, char** argv)
+{
+    size_t n      = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 20000;
+    int    rounds = argc > 2 ? std::atoi(argv[2]) : 20;
+
+    std::mt19937_64 rng(42);
+    std::uniform_int_distribution<uint32_t> hosts(1, 64);
+    std::uniform_real_distribution<double>  wall(60.0, 86400.0), sub(0.0, 86400.0);
+
+    std::vector<Job> jobs(n);
+    std::vector<Job*> queue(n);
+    for (size_t i = 0; i < n; ++i) {
+        jobs[i] = Job{hosts(rng), wall(rng), sub(rng), i};
+        queue[i] = &jobs[i];
+    }
+    const double now = 86400.0;
+
+    printf("%-6s %-9s %12s %12s %8s\n", "policy", "threshold", "runtime_ns", "static_ns", "speedup");
+    for (const auto& [name, p] : STR2POL) {
+        for (bool thr : {false, true}) {
+            threshold_sec = thr ? 6 * 3600.0 : -1.0;
+            double rt = time_ns(queue, rounds, [&](std::vector<Job*>& q){ sort_runtime(q, now, p); });
+            double st = time_ns(queue, rounds, [&](std::vector<Job*>& q){
+                if (thr) sort_static<true >(q, now, p);
+                else     sort_static<false>(q, now, p);
+            });
+            printf("%-6s %-9s %12.0f %12.0f %7.2fx\n",
+                   name.c_str(), thr ? "6h" : "off", rt, st, rt / st);
+        }
+    }
+    return 0;
+}
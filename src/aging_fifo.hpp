@@ -0,0 +1,75 @@
+/**************************************************************
+ *  aging_fifo.hpp  —  jobs below the threshold, in the order
+ *                     they will pass it
+ *
+ *  Jobs arrive by submission time, so the next one to age is
+ *  always the oldest still young: an intrusive list through the
+ *  job records gives
+ *      push / erase / promotion of the front     O(1)
+ *  with no key comparison at all, and the next promotion instant
+ *  is read off the front, for the caller to be woken up then.
+ *  A job queued again with its first submission time (#spec)
+ *  walks back from the tail to its place, past the jobs younger
+ *  than it, or as old and of a later rank.
+ *
+ *  Job must expose submit_time, seq and `Job *older, *younger`.
+ *************************************************************/
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+
+template <class Job>
+class AgingFifo {
+public:
+    void push(Job* j)
+    {
+        Job* at = tail;               // j goes after it
+        while (at && (at->submit_time > j->submit_time ||
+                      (at->submit_time == j->submit_time && at->seq > j->seq)))
+            at = at->older;
+        j->older   = at;
+        j->younger = at ? at->younger : head;
+        (j->younger ? j->younger->older : tail) = j;
+        (at ? at->younger : head) = j;
+        ++n;
+    }
+
+    void erase(Job* j)
+    {
+        (j->older   ? j->older->younger : head) = j->younger;
+        (j->younger ? j->younger->older : tail) = j->older;
+        --n;
+    }
+
+    Job*   front() const { return head; }
+    bool   empty() const { return !head; }
+    size_t size()  const { return n; }
+    void   clear()       { head = tail = nullptr; n = 0; }
+
+    /* f(job) for every job waiting more than `threshold` at now, oldest
+       first; each leaves the list before f sees it                     */
+    template <class F>
+    void promote(double now, double threshold, F f)
+    {
+        while (head && now - head->submit_time > threshold) {
+            Job* j = head;
+            erase(j);
+            f(j);
+        }
+    }
+
+    /* first instant at which promote() takes the front, +inf if empty */
+    double next_due(double threshold) const
+    {
+        if (!head) return HUGE_VAL;
+        double t = head->submit_time + threshold;
+        while (!(t - head->submit_time > threshold)) t = std::nextafter(t, HUGE_VAL);
+        return t;
+    }
+
+private:
+    Job*   head = nullptr;
+    Job*   tail = nullptr;
+    size_t n    = 0;
+};
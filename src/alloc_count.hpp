@@ -0,0 +1,90 @@
+/**************************************************************
+ *  alloc_count.hpp  —  heap allocations of the plug-in, per
+ *                      decision call (counting build only)
+ *
+ *  Built with -DEASY_COUNT_ALLOCS, this header replaces the
+ *  global operator new / delete with counting ones.  Include it
+ *  from exactly one translation unit.  Linked with -Bsymbolic the
+ *  plug-in's own calls bind to them, while the simulator's and
+ *  other libraries' allocations keep going to the usual ones.
+ *  _GLIBCXX_ASSERTIONS makes std::string code be instantiated in
+ *  the plug-in too, instead of running from libstdc++.so.  The
+ *  meson target easy_variants_allocs sets all three.
+ *
+ *  The counter is shared with the plug-in's other threads (the
+ *  #trace writer), so it is atomic; their allocations during a
+ *  call count in it.
+ *
+ *  Without EASY_COUNT_ALLOCS, allocations() is always 0 and
+ *  nothing is replaced.
+ *************************************************************/
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+#ifdef EASY_COUNT_ALLOCS
+# include <atomic>
+# include <cstdlib>
+# include <new>
+
+inline std::atomic<uint64_t> alloc_counter{0};
+
+void* operator new(std::size_t n)
+{
+    alloc_counter.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](std::size_t n) { return ::operator new(n); }
+void* operator new(std::size_t n, const std::nothrow_t&) noexcept
+{
+    alloc_counter.fetch_add(1, std::memory_order_relaxed);
+    return std::malloc(n ? n : 1);
+}
+void* operator new[](std::size_t n, const std::nothrow_t& t) noexcept { return ::operator new(n, t); }
+void  operator delete(void* p) noexcept                        { std::free(p); }
+void  operator delete[](void* p) noexcept                      { std::free(p); }
+void  operator delete(void* p, std::size_t) noexcept           { std::free(p); }
+void  operator delete[](void* p, std::size_t) noexcept         { std::free(p); }
+void  operator delete(void* p, const std::nothrow_t&) noexcept   { std::free(p); }
+void  operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
+
+void* operator new(std::size_t n, std::align_val_t a)
+{
+    alloc_counter.fetch_add(1, std::memory_order_relaxed);
+    std::size_t al = static_cast<std::size_t>(a);
+    if (void* p = std::aligned_alloc(al, (std::max<std::size_t>(n, 1) + al - 1) / al * al)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](std::size_t n, std::align_val_t a)        { return ::operator new(n, a); }
+void  operator delete(void* p, std::align_val_t) noexcept      { std::free(p); }
+void  operator delete[](void* p, std::align_val_t) noexcept    { std::free(p); }
+void  operator delete(void* p, std::size_t, std::align_val_t) noexcept   { std::free(p); }
+void  operator delete[](void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+
+inline constexpr bool counting_allocs = true;
+inline uint64_t allocations() { return alloc_counter.load(std::memory_order_relaxed); }
+#else
+inline constexpr bool counting_allocs = false;
+inline uint64_t allocations() { return 0; }
+#endif
+
+/* allocations per decision call, split by whether jobs were submitted */
+struct AllocStats {
+    struct Tally {
+        uint64_t calls = 0, allocating = 0, total = 0, max = 0;
+
+        void add(uint64_t n)
+        {
+            ++calls;
+            allocating += n > 0;
+            total += n;
+            max = std::max(max, n);
+        }
+    };
+    Tally with_submissions, without;
+
+    void add(uint64_t n, bool submitted) { (submitted ? with_submissions : without).add(n); }
+};
@@ -0,0 +1,164 @@
+/**************************************************************
+ *  availability_profile.hpp  —  free hosts as a step function
+ *                               of time, kept across decisions
+ *
+ *  Every running job contributes one release step (end time,
+ *  nb hosts).  Steps live in a treap keyed by time whose nodes
+ *  carry the sum of their subtree, so
+ *      add / remove                      O(log n)
+ *      earliest(now, free, need)         O(log n)
+ *      released_by(t)                    O(log n)
+ *  instead of rebuilding and sorting the running set per call.
+ *************************************************************/
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+class AvailabilityProfile {
+public:
+    /* q hosts come back at time t */
+    void add(double t, uint32_t q)
+    {
+        if (q == 0) return;
+        if (bump(t, q)) return;
+        int32_t n = new_node(t, q);
+        int32_t l, r;
+        split(root, t, l, r);
+        root = merge(merge(l, n), r);
+    }
+
+    /* forget a release step previously given to add() */
+    void remove(double t, uint32_t q)
+    {
+        if (q == 0) return;
+        int32_t n = find(t);
+        if (n < 0) return;
+        if (nodes[n].q > q) { bump(t, -static_cast<int64_t>(q)); return; }
+
+        int32_t l, mid, r;
+        split(root, t, l, r);                 // l: < t, r: >= t
+        split_le(r, t, mid, r);               // mid: == t
+        if (mid >= 0) free_list.push_back(mid);
+        root = merge(l, r);
+    }
+
+    /* earliest instant >= now at which free + releases >= need */
+    double earliest(double now, uint32_t free_now, uint32_t need) const
+    {
+        if (free_now >= need || root < 0) return now;
+
+        uint64_t acc = free_now;
+        int32_t  n   = root;
+        double   last = now;
+        while (n >= 0) {
+            const Node& nd = nodes[n];
+            uint64_t left = sum(nd.l);
+            if (acc + left >= need) { n = nd.l; continue; }
+            acc += left + nd.q;
+            if (acc >= need) return nd.t > now ? nd.t : now;
+            last = nd.t;
+            n = nd.r;
+        }
+        return last > now ? last : now;       // never enough: last release
+    }
+
+    /* hosts released at or before t */
+    uint64_t released_by(double t) const
+    {
+        uint64_t acc = 0;
+        int32_t  n   = root;
+        while (n >= 0) {
+            const Node& nd = nodes[n];
+            if (nd.t <= t) { acc += sum(nd.l) + nd.q; n = nd.r; }
+            else             n = nd.l;
+        }
+        return acc;
+    }
+
+    uint64_t total() const { return sum(root); }
+    bool     empty() const { return root < 0; }
+
+    void clear()
+    {
+        nodes.clear(); free_list.clear(); root = -1;
+    }
+
+private:
+    struct Node {
+        double   t;
+        uint64_t q;        // hosts released exactly at t
+        uint64_t s;        // subtree sum of q
+        uint32_t prio;
+        int32_t  l, r;
+    };
+
+    std::vector<Node>    nodes;
+    std::vector<int32_t> free_list;
+    int32_t              root = -1;
+    uint32_t             seed = 0x9e3779b9u;
+
+    uint64_t sum(int32_t n) const { return n < 0 ? 0 : nodes[n].s; }
+    void     pull(int32_t n) { nodes[n].s = sum(nodes[n].l) + nodes[n].q + sum(nodes[n].r); }
+
+    int32_t new_node(double t, uint64_t q)
+    {
+        seed ^= seed << 13; seed ^= seed >> 17; seed ^= seed << 5;   // xorshift32
+        Node nd{t, q, q, seed, -1, -1};
+        if (!free_list.empty()) {
+            int32_t n = free_list.back(); free_list.pop_back();
+            nodes[n] = nd;
+            return n;
+        }
+        nodes.push_back(nd);
+        return static_cast<int32_t>(nodes.size() - 1);
+    }
+
+    int32_t find(double t) const
+    {
+        int32_t n = root;
+        while (n >= 0 && nodes[n].t != t) n = (t < nodes[n].t) ? nodes[n].l : nodes[n].r;
+        return n;
+    }
+
+    /* add delta to an existing step and to every sum on its path */
+    bool bump(double t, int64_t delta)
+    {
+        if (find(t) < 0) return false;
+        int32_t n = root;
+        for (;;) {
+            nodes[n].s += delta;
+            if (nodes[n].t == t) { nodes[n].q += delta; return true; }
+            n = (t < nodes[n].t) ? nodes[n].l : nodes[n].r;
+        }
+    }
+
+    /* l: keys < t, r: keys >= t */
+    void split(int32_t n, double t, int32_t& l, int32_t& r)
+    {
+        if (n < 0) { l = r = -1; return; }
+        if (nodes[n].t < t) { split(nodes[n].r, t, nodes[n].r, r); l = n; }
+        else                { split(nodes[n].l, t, l, nodes[n].l); r = n; }
+        pull(n);
+    }
+
+    /* l: keys <= t, r: keys > t */
+    void split_le(int32_t n, double t, int32_t& l, int32_t& r)
+    {
+        if (n < 0) { l = r = -1; return; }
+        if (nodes[n].t <= t) { split_le(nodes[n].r, t, nodes[n].r, r); l = n; }
+        else                 { split_le(nodes[n].l, t, l, nodes[n].l); r = n; }
+        pull(n);
+    }
+
+    int32_t merge(int32_t a, int32_t b)
+    {
+        if (a < 0) return b;
+        if (b < 0) return a;
+        if (nodes[a].prio > nodes[b].prio) {
+            nodes[a].r = merge(nodes[a].r, b); pull(a); return a;
+        }
+        nodes[b].l = merge(a, nodes[b].l); pull(b); return b;
+    }
+};
@@ -0,0 +1,222 @@
+/**************************************************************
+ *  backfill_index.hpp  —  pending jobs bucketed by
+ *                         (log2 nb_hosts, log2 walltime)
+ *
+ *  A backfill candidate must fit in the free hosts and end before
+ *  the reservation.  Jobs are spread over power-of-two classes of
+ *  both quantities; each bucket keeps its jobs in backfill order
+ *  (any order type with insert/erase/begin/end), and scan() merges
+ *  only the buckets whose smallest job could still fit.  Buckets
+ *  that are too wide or too long are never opened, and a bucket
+ *  is dropped as soon as the free hosts fall below its class.
+ *
+ *  Job must expose `nb_hosts` and `walltime`.
+ *************************************************************/
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+template <class Job, class Order>
+class BackfillIndex {
+public:
+    static constexpr uint32_t HOST_CLASSES = 32;    // nb_hosts < 2^32
+    static constexpr uint32_t WALL_CLASSES = 64;    // walltime < 2^64 s
+
+    using Make = std::function<std::unique_ptr<Order>()>;
+
+    /* how to build an empty bucket; set before the first insert */
+    void set_factory(Make m) { make = std::move(m); }
+
+    void insert(Job* j)
+    {
+        uint32_t hc = host_class(j->nb_hosts), wc = wall_class(j->walltime);
+        bucket(hc, wc).insert(j);
+        wmask[hc] |= 1ull << wc;
+        ++count;
+    }
+
+    void erase(Job* j)
+    {
+        if (buckets.empty()) return;
+        uint32_t hc = host_class(j->nb_hosts), wc = wall_class(j->walltime);
+        Order* b = buckets[hc * WALL_CLASSES + wc].get();
+        if (!b) return;
+        size_t before = b->size();
+        b->erase(j);
+        if (b->size() == before) return;
+        if (b->empty()) wmask[hc] &= ~(1ull << wc);
+        --count;
+    }
+
+    size_t size()  const { return count; }
+    bool   empty() const { return count == 0; }
+
+    /* apply f to every bucket ever created (e.g. to advance kinetic ones) */
+    template <class F> void for_each_bucket(F f)
+    {
+        for (auto& b : buckets) if (b) f(*b);
+    }
+
+    /* every job, bucket by bucket (no particular order) */
+    template <class F> void for_each_job(F f) const
+    {
+        for (const auto& b : buckets)
+            if (b) for (auto it = b->begin(); it != b->end(); ++it) f(it->job);
+    }
+
+    /* a lower bound on the nb_hosts of every job (its host class floor) */
+    uint32_t min_width() const
+    {
+        for (uint32_t hc = 0; hc < HOST_CLASSES; ++hc)
+            if (wmask[hc]) return 1u << hc;
+        return UINT32_MAX;
+    }
+
+    /* number of jobs in the buckets scan(max_wall, narrow, ...) would open */
+    size_t candidates(double max_wall, uint32_t narrow, uint32_t free) const
+    {
+        if (free == 0 || count == 0) return 0;
+        uint64_t wlim   = wall_limit(max_wall);
+        uint32_t hc_max = host_class(free);
+        uint32_t hc_any = any_wall_classes(narrow);
+        size_t n = 0;
+        for (uint32_t hc = 0; hc <= hc_max; ++hc) {
+            uint64_t m = wmask[hc] & (hc < hc_any ? ~0ull : wlim);
+            while (m) {
+                uint32_t wc = static_cast<uint32_t>(__builtin_ctzll(m));
+                m &= m - 1;
+                n += buckets[hc * WALL_CLASSES + wc]->size();
+            }
+        }
+        return n;
+    }
+
+    /*  Visit, in the order given by before(a, b), the jobs of every bucket
+     *  whose class may hold a job with nb_hosts <= free_hosts() and
+     *  either walltime <= max_wall or nb_hosts <= narrow (0: no such
+     *  exception).  visit(job) does the exact test and may
+     *  start (hence erase) the job, and returns false to end the scan;
+     *  free_hosts() is re-read after each visit and buckets wider than
+     *  it are dropped.  Returns the number of jobs visited.               */
+    template <class FreeFn, class Before, class Visit>
+    size_t scan(double max_wall, uint32_t narrow, FreeFn free_hosts, Before before, Visit visit)
+    {
+        uint64_t wlim   = wall_limit(max_wall);
+        uint32_t hc_any = any_wall_classes(narrow);
+        return scan_classes([&](uint32_t hc) { return hc < hc_any ? ~0ull : wlim; },
+                            free_hosts, before, visit);
+    }
+
+    /*  Same, with the walltime bound given per host class: a job with
+     *  nb_hosts in [2^hc, 2^(hc+1)) may fit if walltime <= max_wall_of(hc).  */
+    template <class WallFn, class FreeFn, class Before, class Visit>
+    size_t scan_by_class(WallFn max_wall_of, FreeFn free_hosts, Before before, Visit visit)
+    {
+        return scan_classes([&](uint32_t hc) { return wall_limit(max_wall_of(hc)); },
+                            free_hosts, before, visit);
+    }
+
+    void clear()
+    {
+        buckets.clear();
+        std::fill(std::begin(wmask), std::end(wmask), 0);
+        count = 0;
+    }
+
+private:
+    struct Cursor {
+        typename Order::const_iterator it, end;
+        uint32_t                       hc;
+    };
+
+    Make                                 make;
+    std::vector<std::unique_ptr<Order>>  buckets;
+    uint64_t                             wmask[HOST_CLASSES] = {};   // non-empty wall classes
+    size_t                               count = 0;
+    std::vector<Cursor>                  cursors;                     // reused by scan()
+
+    static uint32_t host_class(uint32_t n)
+    {
+        return n ? 31 - static_cast<uint32_t>(__builtin_clz(n)) : 0;
+    }
+
+    static uint32_t wall_class(double w)
+    {
+        if (!(w >= 1.0)) return 0;                       // also negative / NaN
+        int e = std::ilogb(w);
+        return e >= static_cast<int>(WALL_CLASSES) ? WALL_CLASSES - 1 : static_cast<uint32_t>(e);
+    }
+
+    /* wall classes that may hold a job of walltime <= max_wall */
+    static uint64_t wall_limit(double max_wall)
+    {
+        /* a little slack: the caller tests now + walltime <= reserve_t */
+        uint32_t wc_max = wall_class(max_wall * (1 + 1e-12) + 1e-9);
+        return (wc_max >= 63) ? ~0ull : ((2ull << wc_max) - 1);
+    }
+
+    /* host classes below this one may hold a job of nb_hosts <= narrow */
+    static uint32_t any_wall_classes(uint32_t narrow)
+    {
+        return narrow ? host_class(narrow) + 1 : 0;
+    }
+
+    /* the merge behind both scans; class_walls(hc) masks the wall classes */
+    template <class ClassWalls, class FreeFn, class Before, class Visit>
+    size_t scan_classes(ClassWalls class_walls, FreeFn free_hosts, Before before, Visit visit)
+    {
+        uint32_t free = free_hosts();
+        if (free == 0 || count == 0) return 0;
+
+        uint32_t hc_max = host_class(free);
+
+        cursors.clear();
+        for (uint32_t hc = 0; hc <= hc_max; ++hc) {
+            uint64_t m = wmask[hc];
+            if (m) m &= class_walls(hc);
+            while (m) {
+                uint32_t wc = static_cast<uint32_t>(__builtin_ctzll(m));
+                m &= m - 1;
+                const Order& b = *buckets[hc * WALL_CLASSES + wc];
+                cursors.push_back(Cursor{b.begin(), b.end(), hc});
+            }
+        }
+
+        auto later = [&](const Cursor& a, const Cursor& b) {
+            return before(b.it->job, a.it->job);         // min-heap on front job
+        };
+        std::make_heap(cursors.begin(), cursors.end(), later);
+
+        size_t visited = 0;
+        while (!cursors.empty()) {
+            std::pop_heap(cursors.begin(), cursors.end(), later);
+            Cursor& c = cursors.back();
+            if ((1u << c.hc) > free) { cursors.pop_back(); continue; }   // too wide now
+
+            Job* j = (c.it++)->job;                      // step first: visit may erase j
+            ++visited;
+            bool more = visit(j);
+            free = free_hosts();
+            if (!more || free == 0) break;
+
+            if (c.it == c.end) cursors.pop_back();
+            else std::push_heap(cursors.begin(), cursors.end(), later);
+        }
+        cursors.clear();
+        return visited;
+    }
+
+    Order& bucket(uint32_t hc, uint32_t wc)
+    {
+        if (buckets.empty()) buckets.resize(HOST_CLASSES * WALL_CLASSES);
+        auto& b = buckets[hc * WALL_CLASSES + wc];
+        if (!b) b = make();
+        return *b;
+    }
+};
@@ -1,5 +1,4 @@
 #include <cstdint>
-#include <list>
 #include <set>
 #include <vector>
 #include <unordered_map>
@@ -7,6 +6,7 @@
 #include <batprotocol.hpp>
 #include <intervalset.hpp>
 #include "batsim_edc.h"
+#include "kinetic_order.hpp"
 
 using namespace batprotocol;
 
@@ -16,12 +16,24 @@ struct SchedJob {
     uint32_t    nb_hosts;
     double      walltime;      // user-provided bound
     double      submit_time;   // for computing wait/stretch
+    uint64_t    seq;           // arrival rank, breaks expansion-factor ties
+};
+
+// Expansion factor (wait + walltime)/walltime is linear in time; the queue is
+// kept ordered by its opposite so the highest expansion comes first.
+struct ExpLine {
+    static double key(const SchedJob* j, double now) {
+        return -((now - j->submit_time + j->walltime) / j->walltime);
+    }
+    static double intercept(const SchedJob* j) { return j->submit_time / j->walltime - 1.0; }
+    static double slope(const SchedJob* j)     { return -1.0 / j->walltime; }
 };
 
 static MessageBuilder *mb = nullptr;
 static bool format_binary = true;
 
-static std::list<SchedJob*> *pending = nullptr;
+static KineticOrder<SchedJob, ExpLine> *pending = nullptr;
+static uint64_t next_seq = 0;
 static std::unordered_map<std::string, std::set<uint32_t>> allocations;
 static std::unordered_map<std::string, double> end_times;
 static std::set<uint32_t> available_hosts;
@@ -68,13 +80,13 @@ static std::string allocate_hosts(const std::string &job_id, uint32_t q) {
 extern "C" uint8_t batsim_edc_init(const uint8_t*, uint32_t, uint32_t flags) {
     format_binary = (flags & BATSIM_EDC_FORMAT_BINARY);
     mb = new MessageBuilder(!format_binary);
-    pending = new std::list<SchedJob*>();
+    pending = new KineticOrder<SchedJob, ExpLine>();
     return 0;
 }
 
 extern "C" uint8_t batsim_edc_deinit() {
     delete mb;
-    for (auto *j : *pending) delete j;
+    for (const auto &slot : *pending) delete slot.job;
     delete pending;
     allocations.clear();
     end_times.clear();
@@ -92,6 +104,7 @@ extern "C" uint8_t batsim_edc_take_decisions(
     auto *msg = deserialize_message(*mb, !format_binary, what_happened);
     double now = msg->now();
     mb->clear(now);
+    pending->advance(now);
 
     // 1. Handle events
     for (auto *ev : *msg->events()) {
@@ -115,11 +128,12 @@ extern "C" uint8_t batsim_edc_take_decisions(
                 j->nb_hosts   = s->job()->resource_request();
                 j->walltime   = s->job()->walltime();
                 j->submit_time = msg->now();
+                j->seq         = next_seq++;
                 if (j->nb_hosts > platform_nb_hosts) {
                     mb->add_reject_job(j->job_id);
                     delete j;
                 } else {
-                    pending->push_back(j);
+                    pending->insert(j);
                 }
                 break;
             }
@@ -145,35 +159,29 @@ extern "C" uint8_t batsim_edc_take_decisions(
     while (progress && !pending->empty()) {
         progress = false;
 
-        // Sort by expansion factor: (wait + walltime)/walltime
-        std::vector<SchedJob*> sorted(pending->begin(), pending->end());
-        std::stable_sort(sorted.begin(), sorted.end(),
-                         [now](SchedJob* a, SchedJob* b) {
-                             double ea = (now - a->submit_time + a->walltime) / a->walltime;
-                             double eb = (now - b->submit_time + b->walltime) / b->walltime;
-                             return ea > eb;  // highest expansion first
-                         });
-
-        SchedJob *head = sorted.front();
+        // Highest expansion factor first; the kinetic order only swaps
+        // neighbours whose expansion factors crossed since the last call.
+        SchedJob *head = pending->front();
         if (available_hosts.size() >= head->nb_hosts) {
             auto res = allocate_hosts(head->job_id, head->nb_hosts);
             mb->add_execute_job(head->job_id, res);
             end_times[head->job_id] = now + head->walltime;
-            pending->remove(head);
+            pending->erase(head);
             progress = true;
             continue;
         }
 
         double reserve_t = compute_reservation(now, head->nb_hosts);
 
-        for (auto *cand : sorted) {
+        for (auto it = pending->begin(); it != pending->end();) {
+            SchedJob *cand = (it++)->job;   // step first: erase() drops cand
             if (cand == head) continue;
             if (available_hosts.size() >= cand->nb_hosts
                 && now + cand->walltime <= reserve_t) {
                 auto res = allocate_hosts(cand->job_id, cand->nb_hosts);
                 mb->add_execute_job(cand->job_id, res);
                 end_times[cand->job_id] = now + cand->walltime;
-                pending->remove(cand);
+                pending->erase(cand);
                 progress = true;
             }
         }
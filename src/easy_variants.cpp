@@ -8,22 +8,130 @@
  *      "spf@20"         → SPF/SPF   + threshold 20 h
  *      "lqf,lpf@20"     → LQF/LPF   + threshold 20 h
  *
+ *  Jobs waiting longer than the threshold go first, in arrival order of
+ *  aging and primary order among them; the plug-in asks to be called
+ *  back when the next one ages, so none waits for an unrelated event.
+ *
+ *  Options follow, each after a '#':
+ *      "spf@20#extra"   → long jobs may backfill onto the extra nodes
+ *                         (hosts still spare at the shadow time)
+ *      "spf,lpf@20#k4"  → EASY-k: the first 4 jobs of the primary order
+ *                         hold reservations, the others backfill
+ *      "spf@20#cons"    → conservative backfilling: every queued job
+ *                         holds a reservation (backfill order unused)
+ *      "spf@20#los"     → lookahead backfilling: the candidates that
+ *                         fill the most hosts, not the first ones
+ *      "spf@20#pred"    → plan with predicted runtimes (learnt from the
+ *                         completions, runtime_predictor.hpp) instead of
+ *                         the requested walltimes; "#pred=NAME" picks
+ *                         the predictor.  Queue keys use them too.
+ *
+ *      "spf@20#adapt"   → adaptive orders: every hour, replay the queue
+ *                         under each candidate pair for a few hours with
+ *                         predicted runtimes (what_if.hpp) and switch to
+ *                         the best; candidates are the given pair, fcfs,
+ *                         spf and exp, or "#adapt=fcfs/spf,lpf/exp"
+ *      "spf#adapt#target=bsld"
+ *                       → the score #adapt minimises: wait (mean, the
+ *                         default), maxwait or bsld
+ *      "spf#spec"       → speculative backfilling: a job crossing the
+ *                         shadow time still backfills when the longest
+ *                         runtime seen for its shape (scaled to its
+ *                         walltime) ends before it.  Still running then,
+ *                         it is killed if the waiting head's reservation
+ *                         needs its hosts, and registered again as
+ *                         "<id>#r<n>" with its first submission time
+ *                         (speculation.hpp); else it runs on.  Not with #los
+ *      "spf@20#tune=48" → the threshold follows the waits: every hour it
+ *                         is moved to hold the p99 wait of started and
+ *                         waiting jobs at 48 h (starting from 20 h, or
+ *                         48 h without '@'), and each change is logged;
+ *                         it is held, and that logged, when moving it no
+ *                         longer helps, for six hours at most
+ *      "spf#prof"       → time the phases of every decision call and write
+ *                         p50/p99/max per phase and queue depth to
+ *                         out/easy-unified-phases.json and .csv at the
+ *                         end (phase_profile.hpp); "#prof=PREFIX" puts
+ *                         them at PREFIX.json and PREFIX.csv
+ *      "spf#perf"       → #prof with the hardware counters of each phase
+ *                         (cycles, instructions, LLC and branch misses,
+ *                         perf_counters.hpp) added to its report; timing
+ *                         only where they cannot be opened
+ *      "spf#trace"      → Trace Event JSON for ui.perfetto.dev: each call
+ *                         a span, its phases nested in it, and counters
+ *                         of pending jobs, free hosts and the shadow time
+ *                         (trace_writer.hpp), to out/easy-unified-trace.json
+ *                         or "#trace=PATH"
+ *      "spf#live"       → after each decision call, a sample (time, pending
+ *                         jobs, free hosts, jobs started and backfilled,
+ *                         latency) into the shared-memory ring /easy-live
+ *                         (live_telemetry.hpp) or "#live=NAME"; tail it
+ *                         with tools/easy_live while the simulation runs.
+ *                         A ring of that name that already exists is left
+ *                         alone, and the run goes on without telemetry
+ *
+ *  With reservations for more than the head, jobs may run past them on
+ *  any hosts the plan leaves spare, so #extra, #los, #pred, #spec and
+ *  #adapt only matter for plain EASY.
+ *
+ *  A queue order that is not one of the names above is an expression
+ *  over nb_hosts, walltime, submit_time, submit_age and now, smaller
+ *  first (key_program.hpp); ';' separates tie-breaking keys:
+ *      "log10(walltime)*nb_hosts+870*log10(submit_age),spf@20"
+ *      "nb_hosts;-walltime"
+ *  Those run plain EASY (#extra and #pred apply, #cons, #kN, #los and #spec
+ *  not).
+ *
  *  Compile (no external EDC header needed):
  *      g++ -std=c++17 -O2 -fPIC -shared easy_unified.cpp \
  *          $(pkg-config --cflags --libs batsim) \
  *          -o build/libeasy_variants.so
+ *  The meson target easy_variants_allocs is the same plug-in counting
+ *  its heap allocations (alloc_count.hpp): at the end it prints how many
+ *  each call made, apart for calls with and without submissions.  Once
+ *  the queues have reached their size a call without submissions makes
+ *  none; only growth to a new peak does (and #adapt's hourly refit).
  *************************************************************/
  #include <algorithm>
+ #include <cctype>
+ #include <cerrno>
+ #include <cmath>
  #include <cstdint>
- #include <list>
- #include <set>
+ #include <cstdio>
+ #include <cstdlib>
+ #include <memory>
+ #include <queue>
  #include <string>
- #include <unordered_map>
+ #include <type_traits>
  #include <vector>
  
  #include <batprotocol.hpp>
  #include <intervalset.hpp>
  
+ #include "aging_fifo.hpp"
+ #include "alloc_count.hpp"
+ #include "availability_profile.hpp"
+ #include "backfill_index.hpp"
+ #include "host_pool.hpp"
+ #include "job_table.hpp"
+ #include "job_order.hpp"
+ #include "key_program.hpp"
+ #include "kinetic_order.hpp"
+ #include "live_telemetry.hpp"
+ #include "los_knapsack.hpp"
+ #include "order_adapter.hpp"
+ #include "pending_soa.hpp"
+ #include "perf_counters.hpp"
+ #include "phase_profile.hpp"
+ #include "policies.hpp"
+ #include "prediction_repair.hpp"
+ #include "reservation_profile.hpp"
+ #include "runtime_predictor.hpp"
+ #include "speculation.hpp"
+ #include "threshold_tuner.hpp"
+ #include "trace_writer.hpp"
+ #include "what_if.hpp"
+ 
  using namespace batprotocol;
  
  /* ------------------------------------------------------------------------- */
@@ -34,86 +142,1181 @@
  /* ------------------------------------------------------------------------- */
  
  struct SchedJob {
-     std::string job_id;
+     JobHandle   h;            // slot in `jobs` holding id, this record, run state
      uint32_t    nb_hosts;
-     double      walltime;
+     double      walltime;     // runtime planned with (#pred), else as requested
+     double      req_walltime; // as requested: the kill bound
      double      submit_time;
+     uint64_t    seq;          // arrival rank, tie-breaker of every order
+     uint32_t    pos;          // slot in the engine's pending arrays
+     double      res_start;    // reserved start (reserving engines)
+     bool        reserved;     // holds a reservation (reserving engines)
+     bool        aged;         // past THRESHOLD_SEC, served before the rest
+     SchedJob   *older, *younger;   // AgingFifo links while young
+     double      guess;        // #spec: runtime bound, for speculative backfills
+     double      kill_at;      // #spec: started past the shadow time, killed then
+     uint32_t    profile;      // #spec: interned profile id, to register it again
+     uint32_t    runs;         // #spec: times killed and registered again
  };
  
  /* globals */
  static MessageBuilder *mb               = nullptr;
  static bool            format_bin       = true;
- static std::list<SchedJob*>            *pending = nullptr;
- static std::unordered_map<std::string, std::set<uint32_t>> allocations;
- static std::unordered_map<std::string, double>              end_times;
- static std::set<uint32_t>                                   available_hosts;
+ static JobTable<SchedJob>  jobs;      // ids, pooled records, running jobs
+ static HostPool            hosts;     // free hosts
+ static AvailabilityProfile profile;   // release steps of running jobs
  static uint32_t platform_nb_hosts = 0;
+ static uint64_t next_seq          = 0;
+ 
+ /* decision calls, full passes, calls settled by the fast path */
+ static uint64_t nb_calls = 0, nb_passes = 0, nb_fast = 0;
+ 
+ /* jobs started, and those of them backfilled past the primary head */
+ static uint64_t nb_started = 0, nb_backfilled = 0;
+ 
+ /* #los selections, and those made on blocks of hosts */
+ static uint64_t nb_los = 0, nb_los_coarse = 0;
+ 
+ /* heap allocations per call (counting build, alloc_count.hpp) */
+ static AllocStats alloc_stats;
+ 
+ /* #pred: planned runtimes, and the running jobs outliving theirs */
+ static std::unique_ptr<RuntimePredictor> predictor;
+ static std::unique_ptr<RuntimePredictor> side_predictor;   // learnt runtimes without #pred
+ static PredictionRepair prediction_repair;
+ 
+ /* #spec: speculative jobs by kill instant, killed jobs run again */
+ static Speculation spec;
  
  /* ------------------------------------------------------------------------- */
- /*  Policies                                                                 */
- enum class Policy { EXP, FCFS, LCFS, LPF, LQF, SPF, SQF };
+ /*  Policies (keys in policies.hpp)                                          */
  static Policy primary_policy  = Policy::FCFS;
  static Policy backfill_policy = Policy::FCFS;
  
- static const std::unordered_map<std::string, Policy> STR2POL = {
-     {"exp",Policy::EXP},{"fcfs",Policy::FCFS},{"lcfs",Policy::LCFS},
-     {"lpf",Policy::LPF},{"lqf",Policy::LQF},{"spf",Policy::SPF},
-     {"sqf",Policy::SQF}
- };
+ /* queue keys given as expressions instead (key_program.hpp); empty ⇒ built-in */
+ static std::string primary_expr, backfill_expr;
  
  /* optional threshold (seconds); <0 ⇒ disabled */
  static double THRESHOLD_SEC = -1.0;
+ static double aging_wake    = -1;     // last call-me-later asked for
+ 
+ /* #tune: the threshold steered by the waits */
+ static ThresholdTuner tuner;
+ 
+ /* '#' options of the argument string */
+ struct Options {
+     bool   extra_nodes  = false;   // #extra: EASY extra-node backfilling
+     bool   conservative = false;   // #cons : conservative backfilling
+     size_t depth        = 1;       // #kN   : reservations for the first N jobs
+     bool   lookahead    = false;   // #los  : LOS backfilling (EASY)
+     bool   speculative  = false;   // #spec : backfill on predicted runtimes, kill late ones
+     std::string predictor;         // #pred[=NAME]: planned runtimes (EASY)
+     std::string adapt;             // #adapt[=LIST]: candidate orders, "*" ⇒ default
+     WhatIfMetric target = WhatIfMetric::WAIT;   // #target=NAME: what #adapt minimises
+     double tune_p99     = -1;      // #tune=H: p99 wait the threshold holds (s); <0 ⇒ off
+     std::string profile;           // #prof[=PREFIX]: phase latency report, empty ⇒ off
+     std::string trace;             // #trace[=PATH]: Trace Event JSON, empty ⇒ off
+     bool   perf         = false;   // #perf : hardware counters in the #prof report
+     std::string live;              // #live[=NAME]: telemetry ring in shared memory, empty ⇒ off
+ };
+ static Options opts;
+ static constexpr size_t MAX_DEPTH = size_t(1) << 20;   // largest #kN
+ 
+ /* #prof: time of each phase of the decision calls (phase_profile.hpp) */
+ static std::unique_ptr<PhaseProfile> phases;
+ 
+ /* #trace: the same phases as spans, with counters, to a Perfetto trace */
+ static std::unique_ptr<TraceWriter> tracer;
+ 
+ /* #perf: cycles, instructions, LLC and branch misses of the same phases */
+ static std::unique_ptr<PerfCounters> counters;
+ 
+ /* #live: a sample per decision call, for tools/easy_live to tail */
+ static std::unique_ptr<LiveWriter> telemetry;
  
  /* ------------------------------------------------------------------------- */
- /* key function                                                              */
- static double key_for(const SchedJob* j, double now, Policy p)
+ /* helpers                                                                   */
+ static double compute_reservation(double now, uint32_t need)
+ {
+     PhaseTimer t(phases.get(), Phase::RESERVATION);
+     double r = profile.earliest(now, hosts.free_count(), need);
+     if (phases && r != HUGE_VAL) phases->count(Counter::RESERVE_T, r);
+     return r;
+ }
+ 
+ /* host ranges a job's slot holds room for from its submission on, so that
+    starting it does not allocate unless its hosts come in more pieces   */
+ static constexpr uint32_t HOST_RANGES_RESERVED = 64;
+ 
+ static std::string host_str;          // resources of the last execute decision
+ 
+ static const std::string& allocate(JobTable<SchedJob>::Running& run, uint32_t q)
+ {
+     hosts.claim(q, run.hosts);
+     HostPool::to_string(run.hosts, host_str);
+     return host_str;
+ }
+ 
+ /* hosts, execute decision, release step; the engine drops j from its queues.
+    A job to kill at kill_at (#spec) releases its hosts then at the latest.  */
+ static void launch_job(SchedJob* j, double now, double kill_at = HUGE_VAL)
+ {
+     JobTable<SchedJob>::Running& run = jobs.running(j->h);
+     const std::string& res=allocate(run, j->nb_hosts);
+     mb->add_execute_job(jobs.id(j->h),res);
+     j->kill_at   = kill_at;
+     if (kill_at != HUGE_VAL) spec.started(j->h, kill_at);
+     run.start    = now;
+     run.end      = std::min(now+j->walltime, kill_at);
+     run.nb_hosts = j->nb_hosts;
+     run.active   = true;
+     profile.add(run.end, run.nb_hosts);
+     if (j->walltime < j->req_walltime) prediction_repair.watch(run.end, j->h);
+     if (tuner.on()) tuner.started(now - j->submit_time);
+     ++nb_started;
+ }
+ 
+ /* be called back at t.  Batsim refuses an id still pending, and a wake
+    may be asked for again before the previous one fired, so every call
+    gets its own id, "kind-N".  A call whose reason has gone meanwhile
+    finds nothing due and changes nothing.                              */
+ static uint64_t    nb_wakes = 0;
+ static std::string wake_id;   // reused: no allocation once long enough
+ 
+ static void request_call(const char* kind, double t)
+ {
+     char n[24];
+     snprintf(n, sizeof n, "-%llu", (unsigned long long)++nb_wakes);
+     wake_id.assign(kind);
+     wake_id += n;
+     mb->add_call_me_later(wake_id, TemporalTrigger::make_one_shot(t));
+ }
+ 
+ /* @T: be called back at t, when the next young job ages */
+ static void request_aging_wake(double t)
+ {
+     if (t == HUGE_VAL || t == aging_wake) return;
+     aging_wake = t;
+     request_call("aging", t);
+ }
+ 
+ /* ------------------------------------------------------------------------- */
+ /*  Engines                                                                  */
+ /*  One engine per (primary, backfill, threshold) and mode is compiled; init */
+ /*  picks one and the decision loop runs without any policy branch.  Static  */
+ /*  policies keep their order in persistent indexes, EXP in kinetic orders   */
+ /*  repaired only when two jobs cross.                                       */
+ struct Engine {
+     virtual ~Engine() = default;
+     virtual void   advance(double now)  = 0;   // must precede any insertion
+     virtual void   submit(SchedJob* j)  = 0;   // j->seq set: a job run again keeps its
+     virtual void   decide(double now)   = 0;   // start what can start now
+     virtual void   begin()              = 0;   // platform hosts are known
+     virtual void   finished(const JobTable<SchedJob>::Running& run, double now) = 0;
+     virtual void   releases_moved()     = 0;   // a running job's end was put back
+     virtual size_t pending() const      = 0;
+     virtual double next_aging() const   = 0;   // when a young job ages next, +inf if never
+     /* first job of the primary order at now, aged jobs promoted; nullptr if none */
+     virtual const SchedJob* head(double now) = 0;
+ };
+ 
+ template <Policy P, Policy B, bool Threshold>
+ class EasyEngine final : public Engine {
+     static constexpr bool P_EXP = (P == Policy::EXP);
+     static constexpr bool B_EXP = (B == Policy::EXP);
+ 
+     /* a bucket visit costs about as much as this many lanes of find_fit */
+     static constexpr size_t SOA_SCAN_RATIO = 32;
+ 
+     /* lookahead: candidates per selection, down to LOS_MIN_DEPTH, and table
+        cells per selection (past that, hosts are counted in blocks)         */
+     static constexpr size_t LOS_DEPTH     = 64;
+     static constexpr size_t LOS_MIN_DEPTH = 8;
+     static constexpr size_t LOS_CELLS     = size_t(1) << 20;
+ 
+     using Primary  = std::conditional_t<P_EXP,
+                          KineticTournament<SchedJob, ExpLine<SchedJob>>,      // head only
+                          JobOrder<SchedJob, StaticKey<P, SchedJob>>>;
+     using Bucket   = std::conditional_t<B_EXP,
+                          KineticOrder<SchedJob, ExpLine<SchedJob>>,
+                          JobOrder<SchedJob, StaticKey<B, SchedJob>>>;
+ 
+     Primary  young;                       // primary order, below threshold
+     Primary  aged;                        // primary order, past threshold
+     AgingFifo<SchedJob> arrivals;         // young jobs, next ones to age first
+     BackfillIndex<SchedJob, Bucket> bf;   // every pending job, backfill order
+     PendingSoA<SchedJob> soa;             // same jobs as arrays, for the fit kernel
+     double   kinetic_now = 0;             // time the kinetic orders hold for
+ 
+     LosKnapsack                  los;         // lookahead selection
+     std::vector<LosKnapsack::Item> los_items; // reused by lookahead()
+     std::vector<SchedJob*>       los_jobs;
+     std::vector<uint32_t>        los_greedy;
+ 
+     /*  Left by the last pass when its head stayed blocked: no pending job
+         could start then, and none can later while the hosts and releases
+         are untouched and the head is the same (the reservation only gets
+         closer).  A submission that would fit, or any host change, makes
+         it dirty; a free count below every pending width needs nothing.  */
+     struct Settled {
+         bool      valid     = false;
+         bool      dirty     = false;
+         SchedJob* head      = nullptr;
+         double    reserve   = 0;
+         uint32_t  extra     = 0;      // hosts spare at the shadow time
+         uint32_t  free      = 0;
+         uint32_t  min_width = 0;      // lower bound of the pending widths
+     } settled;
+ 
+ public:
+     EasyEngine()
+     {
+         bf.set_factory([this]{
+             auto o = std::make_unique<Bucket>();
+             if constexpr (B_EXP) o->advance(kinetic_now);
+             return o;
+         });
+     }
+ 
+     void advance(double now) override
+     {
+         if constexpr (P_EXP) { young.advance(now); aged.advance(now); }
+         if constexpr (B_EXP) bf.for_each_bucket([&](Bucket& o){ o.advance(now); });
+         kinetic_now = now;
+     }
+ 
+     void submit(SchedJob* j) override
+     {
+         j->aged = false;
+         young.insert(j, aged);            // into a node an aged job left, if any
+         if constexpr (Threshold) arrivals.push(j);
+         bf.insert(j);
+         soa.insert(j);
+ 
+         if (settled.valid) {
+             settled.min_width = std::min(settled.min_width, j->nb_hosts);
+             if (j->nb_hosts<=settled.free &&
+                 (j->submit_time+j->walltime<=settled.reserve ||
+                  j->nb_hosts<=settled.extra ||
+                  (opts.speculative && j->submit_time+j->guess<=settled.reserve)))
+                 settled.dirty = true;
+         }
+     }
+ 
+     void begin() override { settled.dirty = true; }
+ 
+     void finished(const JobTable<SchedJob>::Running&, double) override
+     {
+         settled.dirty = true;
+     }
+ 
+     void releases_moved() override { settled.dirty = true; }
+ 
+     const SchedJob* head(double now) override
+     {
+         promote_aged(now);
+         return bf.empty() ? nullptr : primary_head();
+     }
+ 
+     size_t pending() const override { return bf.size(); }
+ 
+     double next_aging() const override
+     {
+         if constexpr (Threshold) return arrivals.next_due(THRESHOLD_SEC);
+         return HUGE_VAL;
+     }
+ 
+     void decide(double now) override
+     {
+         promote_aged(now);
+ 
+         if (settled.valid &&
+             (hosts.free_count()<settled.min_width ||
+              (!settled.dirty && primary_head()==settled.head))) {
+             ++nb_fast; return;
+         }
+         ++nb_passes;
+ 
+         SchedJob* head=nullptr;
+         double reserve_t=now;
+         uint32_t extra=0;
+         bool progress=true;
+         while(progress && !bf.empty()) {
+             progress=false;
+ 
+             head=primary_head();
+ 
+             if (hosts.free_count()>=head->nb_hosts) {
+                 start(head, now);
+                 progress=true; continue;
+             }
+ 
+             reserve_t=compute_reservation(now, head->nb_hosts);
+ 
+             /* shadow time = reserve_t; hosts it leaves over after the head
+                may take jobs that run past it                              */
+             extra=0;
+             if (opts.extra_nodes)
+                 extra=static_cast<uint32_t>(hosts.free_count()+
+                                             profile.released_by(reserve_t)-head->nb_hosts);
+             uint32_t narrow=std::min(extra, hosts.free_count());
+             if (opts.speculative) narrow=hosts.free_count();   // any length may guess short
+ 
+             PhaseTimer t(phases.get(), Phase::BACKFILL);
+ 
+             /* Nothing to open, or so many jobs to walk that one vector pass
+                over the pending arrays is cheaper to prove none of them fits
+                (the head is too wide, so any fitting job is a candidate).  */
+             size_t cands=bf.candidates(reserve_t-now, narrow, hosts.free_count());
+             if (cands==0) break;
+             if (cands*SOA_SCAN_RATIO>=soa.size() &&
+                 !soa.find_fit(hosts.free_count(), now, reserve_t) &&
+                 !(narrow && soa.find_fit(narrow, now, HUGE_VAL))) break;
+ 
+             /* only buckets that can hold a fitting job are opened */
+             auto free_hosts=[]{ return hosts.free_count(); };
+             auto before=[now](const SchedJob* a, const SchedJob* b){
+                 double ka=policy_key<B>(a,now), kb=policy_key<B>(b,now);
+                 return ka<kb || (ka==kb && a->seq<b->seq);
+             };
+             if (opts.lookahead) {
+                 progress=lookahead(now, reserve_t, extra, free_hosts, before);
+                 continue;
+             }
+             auto visit=[&](SchedJob* cand){
+                 if (hosts.free_count()<cand->nb_hosts) return true;
+                 double kill_at=HUGE_VAL;
+                 if (now+cand->walltime>reserve_t) {
+                     if (cand->nb_hosts<=extra)
+                         extra-=cand->nb_hosts;       // still running at the shadow time
+                     else if (opts.speculative && now+cand->guess<=reserve_t)
+                         kill_at=reserve_t;           // gone by then, or killed
+                     else return true;
+                 }
+                 start(cand, now, kill_at); progress=true;
+                 ++nb_backfilled;
+                 return true;
+             };
+             bf.scan(reserve_t-now, std::max(extra, narrow), free_hosts, before, visit);
+         }
+ 
+         settled = Settled();
+         if (!bf.empty()) {
+             settled.valid     = true;
+             settled.head      = head;
+             settled.reserve   = reserve_t;
+             settled.extra     = extra;
+             settled.free      = hosts.free_count();
+             settled.min_width = bf.min_width();
+         }
+     }
+ 
+ private:
+     /* LOS: the first candidates (as many as the table bound allows), then
+        the subset of them filling the most hosts; the EASY loop comes back
+        for the next ones while this makes progress.  On wide machines the
+        table counts hosts in blocks, and the greedy choice of the same
+        candidates is kept when it fills more.                             */
+     template <class FreeFn, class Before>
+     bool lookahead(double now, double reserve_t, uint32_t& extra,
+                    FreeFn free_hosts, Before before)
+     {
+         uint32_t free = hosts.free_count();
+         size_t   cap  = LOS_DEPTH;
+         uint32_t unit = 1;
+         while (cap > LOS_MIN_DEPTH && LosKnapsack::cells(cap, free, extra) > LOS_CELLS) cap /= 2;
+         while (LosKnapsack::cells(cap, free, extra, unit) > LOS_CELLS) unit *= 2;
+ 
+         los_items.clear();
+         los_jobs.clear();
+         auto collect=[&](SchedJob* cand){
+             if (free<cand->nb_hosts) return true;
+             bool past = now+cand->walltime>reserve_t;
+             if (past && cand->nb_hosts>extra) return true;
+             los_items.push_back(LosKnapsack::Item{cand->nb_hosts, past});
+             los_jobs.push_back(cand);
+             return los_jobs.size()<cap;
+         };
+         bf.scan(reserve_t-now, extra, free_hosts, before, collect);
+         if (los_jobs.empty()) return false;
+ 
+         const std::vector<uint32_t>* pick = &los.select(los_items, free, extra, unit);
+         ++nb_los;
+         if (unit > 1) {
+             ++nb_los_coarse;
+             uint64_t by_table = 0, by_order = 0;
+             for (uint32_t i : *pick) by_table += los_items[i].hosts;
+             los_greedy.clear();
+             uint32_t f = free, e = extra;
+             for (uint32_t i = 0; i < los_items.size(); ++i) {
+                 const LosKnapsack::Item& it = los_items[i];
+                 if (it.hosts > f || (it.past && it.hosts > e)) continue;
+                 f -= it.hosts;
+                 if (it.past) e -= it.hosts;
+                 by_order += it.hosts;
+                 los_greedy.push_back(i);
+             }
+             if (by_order > by_table) pick = &los_greedy;
+         }
+         for (uint32_t i : *pick) {
+             if (los_items[i].past) extra-=los_items[i].hosts;
+             start(los_jobs[i], now);
+             ++nb_backfilled;
+         }
+         return true;
+     }
+ 
+     void start(SchedJob* j, double now, double kill_at = HUGE_VAL)
+     {
+         launch_job(j, now, kill_at);
+         if constexpr (Threshold) if (!j->aged) arrivals.erase(j);
+         (j->aged ? aged : young).erase(j);
+         bf.erase(j);
+         soa.erase(j);
+     }
+ 
+     /* move every job waiting for more than THRESHOLD_SEC to the aged index */
+     void promote_aged(double now)
+     {
+         if constexpr (Threshold) {
+             PhaseTimer t(phases.get(), Phase::ORDER);
+             arrivals.promote(now, THRESHOLD_SEC, [this](SchedJob* j){
+                 j->aged = true;
+                 young.move_to(j, aged);
+             });
+         }
+     }
+ 
+     /* first job of the primary order: aged jobs first, then policy */
+     SchedJob* primary_head() const
+     {
+         if constexpr (Threshold) if (!aged.empty()) return aged.front();
+         return young.front();
+     }
+ };
+ 
+ /*  Reservation depth k (EASY-k, conservative when unbounded): the first k  */
+ /*  jobs of the primary order hold a reservation in the plan, placed at     */
+ /*  their earliest fit when they join that set and kept across calls; a     */
+ /*  job pushed out of it by a better one hands its slot back.  The others   */
+ /*  start, in backfill order, when the plan has room for them all along     */
+ /*  their walltime.  A job ending before its walltime hands its hosts back  */
+ /*  and the reservations are compressed in primary order, exactly for the   */
+ /*  first ones and by moves to now for the rest; none ever moves later.     */
+ template <Policy P, Policy B, bool Threshold>
+ class ReservingEngine final : public Engine {
+     static constexpr bool P_EXP = (P == Policy::EXP);
+     static constexpr bool B_EXP = (B == Policy::EXP);
+ 
+     /* work of the exact part of a compression pass: one unit per job
+        examined and per plan stretch skipped.  Past it, jobs only move
+        to now when they fit there, so an early completion costs
+        O(COMPRESS_STEPS log n) plus one cheap test per reserved job    */
+     static constexpr size_t COMPRESS_STEPS = 256;
+ 
+     using Held     = std::conditional_t<P_EXP,
+                          KineticOrder<SchedJob, ExpLine<SchedJob>>,
+                          JobOrder<SchedJob, StaticKey<P, SchedJob>>>;
+     using Waiting  = std::conditional_t<P_EXP,
+                          KineticTournament<SchedJob, ExpLine<SchedJob>>,     // head only
+                          JobOrder<SchedJob, StaticKey<P, SchedJob>>>;
+     using Bucket   = std::conditional_t<B_EXP,
+                          KineticOrder<SchedJob, ExpLine<SchedJob>>,
+                          JobOrder<SchedJob, StaticKey<B, SchedJob>>>;
+     struct StartKey { static double key(const SchedJob* j) { return j->res_start; } };
+ 
+     size_t   depth;                        // k
+     Held     held_young, held_aged;        // reserved jobs, primary order
+     Waiting  wait_young, wait_aged;        // the others, primary order
+     AgingFifo<SchedJob> arrivals;          // young jobs, next ones to age first
+     BackfillIndex<SchedJob, Bucket> bf;    // the others, backfill order
+     JobOrder<SchedJob, StartKey> due;      // reserved jobs, by reservation
+     ReservationProfile plan;               // hosts left by running + reserved jobs
+     std::vector<SchedJob*> ready;          // reused by decide()
+     bool     compress_pending = false;     // hosts came back early since the last pass
+     bool     dirty            = false;     // a waiting job may have room now
+     double   now_ = 0;
+     double   wake = -1;                    // last call-me-later asked for
+ 
+ public:
+     explicit ReservingEngine(size_t k) : depth(k)
+     {
+         bf.set_factory([this]{
+             auto o = std::make_unique<Bucket>();
+             if constexpr (B_EXP) o->advance(now_);
+             return o;
+         });
+     }
+ 
+     void advance(double now) override
+     {
+         if constexpr (P_EXP) {
+             held_young.advance(now); held_aged.advance(now);
+             wait_young.advance(now); wait_aged.advance(now);
+         }
+         if constexpr (B_EXP) bf.for_each_bucket([&](Bucket& o){ o.advance(now); });
+         plan.trim(now);
+         now_ = now;
+     }
+ 
+     void begin() override { plan.reset(now_, hosts.free_count()); }
+ 
+     void submit(SchedJob* j) override
+     {
+         j->aged     = false;
+         j->reserved = false;
+         if constexpr (Threshold) arrivals.push(j);
+         wait(j);
+         fill();
+         if (!j->reserved && j->nb_hosts <= hosts.free_count()) dirty = true;
+     }
+ 
+     void finished(const JobTable<SchedJob>::Running& run, double now) override
+     {
+         if (now < run.end) {
+             plan.add(now, run.end, run.nb_hosts);
+             compress_pending = true;
+         }
+         dirty = true;
+     }
+ 
+     void releases_moved() override {}          // runtimes are never predicted here
+ 
+     const SchedJob* head(double) override { return nullptr; }   // never speculates
+ 
+     size_t pending() const override { return due.size() + bf.size(); }
+ 
+     double next_aging() const override
+     {
+         if constexpr (Threshold) return arrivals.next_due(THRESHOLD_SEC);
+         return HUGE_VAL;
+     }
+ 
+     void decide(double now) override
+     {
+         promote_aged(now);
+         fill();
+         bool due_now = !due.empty() && due.front()->res_start <= now;
+         if (!compress_pending && !due_now && !dirty) { ++nb_fast; request_wake(now); return; }
+         ++nb_passes;
+ 
+         if (compress_pending) {
+             PhaseTimer t(phases.get(), Phase::RESERVATION);
+             size_t budget = COMPRESS_STEPS;
+             if constexpr (Threshold) compress(held_aged, now, budget);
+             compress(held_young, now, budget);
+             compress_pending = false;
+         }
+ 
+         /* jobs joining the reserved set may be due at once */
+         bool progress = true;
+         while (progress) {
+             progress = false;
+             ready.clear();
+             for (auto it = due.begin(); it != due.end() && it->key <= now; ++it)
+                 ready.push_back(it->job);
+             for (SchedJob* j : ready)
+                 if (hosts.free_count() >= j->nb_hosts) { start(j, now); progress = true; }
+             if (progress) fill();
+         }
+ 
+         backfill(now);
+         dirty = false;
+         request_wake(now);
+     }
+ 
+ private:
+     size_t held() const { return held_young.size() + held_aged.size(); }
+ 
+     /* best waiting job, worst reserved one */
+     SchedJob* wait_head() const
+     {
+         if constexpr (Threshold) if (!wait_aged.empty()) return wait_aged.front();
+         return wait_young.front();
+     }
+ 
+     SchedJob* held_tail() const
+     {
+         if constexpr (Threshold) if (held_young.empty()) return held_aged.back();
+         return held_young.back();
+     }
+ 
+     /* primary order: aged jobs first, then policy key, then arrival */
+     bool ranks_before(const SchedJob* a, const SchedJob* b) const
+     {
+         if constexpr (Threshold) if (a->aged != b->aged) return a->aged;
+         double ka = policy_key<P>(a, now_), kb = policy_key<P>(b, now_);
+         return ka < kb || (ka == kb && a->seq < b->seq);
+     }
+ 
+     /* keep the reserved set the first `depth` jobs of the primary order */
+     void fill()
+     {
+         PhaseTimer t(phases.get(), Phase::RESERVATION);
+         while (SchedJob* w = wait_head()) {
+             if (held() >= depth) {
+                 SchedJob* h = held_tail();
+                 if (!ranks_before(w, h)) break;
+                 release(h);
+             }
+             unwait(w);
+             hold(w);
+         }
+     }
+ 
+     void wait(SchedJob* j)
+     {
+         (j->aged ? wait_aged : wait_young).insert(j);
+         bf.insert(j);
+     }
+ 
+     void unwait(SchedJob* j)
+     {
+         (j->aged ? wait_aged : wait_young).erase(j);
+         bf.erase(j);
+     }
+ 
+     void hold(SchedJob* j)
+     {
+         j->reserved = true;
+         (j->aged ? held_aged : held_young).insert(j);
+         reserve(j, plan.earliest(now_, j->nb_hosts, j->walltime));
+     }
+ 
+     void release(SchedJob* j)
+     {
+         due.erase(j);
+         plan.add(j->res_start, j->res_start + j->walltime, j->nb_hosts);
+         (j->aged ? held_aged : held_young).erase(j);
+         j->reserved = false;
+         wait(j);
+         compress_pending = true;
+     }
+ 
+     void reserve(SchedJob* j, double t)
+     {
+         j->res_start = t;
+         plan.add(t, t + j->walltime, -static_cast<int64_t>(j->nb_hosts));
+         due.insert(j);
+     }
+ 
+     /* a reservation left behind by a budgeted pass may start at an
+        instant no job ends at: make sure Batsim calls back then */
+     void request_wake(double now)
+     {
+         if (due.empty()) return;
+         double t = due.front()->res_start;
+         if (t <= now || t == wake) return;
+         wake = t;
+         request_call("resv-wake", t);
+     }
+ 
+     /* give the jobs of `order` their earliest slot, given those before
+        them, while the budget lasts; then only look for jobs fitting now */
+     void compress(const Held& order, double now, size_t& budget)
+     {
+         auto it = order.begin();
+         for (; it != order.end() && budget > 0; ++it) {
+             --budget;
+             SchedJob* j = it->job;
+             if (j->res_start <= now) continue;
+             if (plan.max_over(now, j->res_start) < j->nb_hosts) continue;   // no room before it
+             double old = j->res_start;
+             due.erase(j);
+             plan.add(old, old + j->walltime, j->nb_hosts);
+             reserve(j, std::min(old, plan.earliest(now, j->nb_hosts, j->walltime, &budget)));
+         }
+         int64_t free_now = plan.at(now);
+         for (; it != order.end() && free_now > 0; ++it) {
+             SchedJob* j = it->job;
+             if (j->res_start <= now || j->nb_hosts > free_now) continue;
+             /* from its own slot on the job's hosts are already counted */
+             double old = j->res_start;
+             if (!plan.fits(now, j->nb_hosts, std::min(j->walltime, old - now))) continue;
+             due.erase(j);
+             plan.add(old, old + j->walltime, j->nb_hosts);
+             reserve(j, now);
+             free_now -= j->nb_hosts;
+         }
+     }
+ 
+     /* waiting jobs the plan has room for from now to their walltime; a
+        host class is only opened for walltimes its narrowest job could
+        run before the plan runs short of it                              */
+     void backfill(double now)
+     {
+         if (bf.empty()) return;
+         PhaseTimer t(phases.get(), Phase::BACKFILL);
+         int64_t  avail = plan.at(now);
+         uint32_t room  = static_cast<uint32_t>(std::clamp<int64_t>(avail, 0, hosts.free_count()));
+         if (room == 0) return;
+ 
+         auto max_wall = [&](uint32_t hc){ return plan.until(now, int64_t(1) << hc) - now; };
+         auto free_hosts = [&]{ return room; };
+         auto before = [now](const SchedJob* a, const SchedJob* b){
+             double ka=policy_key<B>(a,now), kb=policy_key<B>(b,now);
+             return ka<kb || (ka==kb && a->seq<b->seq);
+         };
+         auto visit = [&](SchedJob* cand){
+             if (cand->nb_hosts > room || !plan.fits(now, cand->nb_hosts, cand->walltime))
+                 return true;
+             room -= cand->nb_hosts;
+             start(cand, now);
+             ++nb_backfilled;
+             return true;
+         };
+         bf.scan_by_class(max_wall, free_hosts, before, visit);
+     }
+ 
+     void start(SchedJob* j, double now)
+     {
+         if (j->reserved) {
+             /* started after its slot (its hosts came back late): the plan
+                keeps it for the whole walltime from now                   */
+             if (j->res_start < now)
+                 plan.add(std::max(j->res_start + j->walltime, now), now + j->walltime,
+                          -static_cast<int64_t>(j->nb_hosts));
+             due.erase(j);
+             (j->aged ? held_aged : held_young).erase(j);
+         } else {
+             plan.add(now, now + j->walltime, -static_cast<int64_t>(j->nb_hosts));
+             unwait(j);
+         }
+         launch_job(j, now);
+         if constexpr (Threshold) if (!j->aged) arrivals.erase(j);
+     }
+ 
+     /* move every job waiting for more than THRESHOLD_SEC to the aged indexes */
+     void promote_aged(double now)
+     {
+         if constexpr (Threshold) {
+             PhaseTimer t(phases.get(), Phase::ORDER);
+             arrivals.promote(now, THRESHOLD_SEC, [this](SchedJob* j){
+                 j->aged = true;
+                 if (j->reserved) held_young.move_to(j, held_aged);
+                 else             wait_young.move_to(j, wait_aged);
+             });
+         }
+     }
+ };
+ 
+ /*  Expression keys (key_program.hpp): both orders are programs run over the */
+ /*  pending arrays.  Primary keys sit in rows beside those arrays; the ones  */
+ /*  moving with time are evaluated again at every pass (their fixed parts    */
+ /*  are kept per job), the others once at submission.  The first HEADS jobs  */
+ /*  of the primary order come from one scan and last until they have all     */
+ /*  started (across calls too when the keys stay put).  Backfill keys are    */
+ /*  evaluated for the jobs that fit only, taken from a heap until no host    */
+ /*  is left for them.  Same EASY loop and ties as EasyEngine: aged jobs      */
+ /*  first (a lead key, flipped as they leave the aging FIFO), then the keys, */
+ /*  then arrival.                                                            */
+ class ExprEngine final : public Engine {
+     static constexpr size_t HEADS = 8;
+ 
+     std::vector<KeyProgram> prim, back;    // lexicographic keys
+     bool   timed = false;                  // primary keys move with time
+     size_t lead;                           // 1 with a threshold: 0 if aged, else 1
+     AgingFifo<SchedJob> arrivals;          // young jobs, next ones to age first
+     size_t nk;                             // primary key columns, lead included
+     size_t ns = 0;                         // statics of the moving keys, per job
+     std::vector<size_t>    st_at;          // first static of each primary key
+     PendingSoA<SchedJob> soa;
+     std::vector<double>    pk;             // nk primary keys per entry, by pos
+     std::vector<double>    ps;             // ns statics per entry, by pos
+     std::vector<double>    col;            // one moving key of every entry
+     std::vector<SchedJob*> heads;          // first jobs of the primary order
+ 
+     std::vector<SchedJob*> cands;          // backfill candidates
+     std::vector<uint32_t>  c_hosts, order; // ... as arrays, and their ranking
+     std::vector<double>    c_wall, c_submit, bk;
+ 
+     /* as in EasyEngine; the head is only compared when keys stay put */
+     struct Settled {
+         bool      valid     = false;
+         bool      dirty     = false;
+         SchedJob* head      = nullptr;
+         double    reserve   = 0;
+         uint32_t  extra     = 0;
+         uint32_t  free      = 0;
+         uint32_t  min_width = 0;
+     } settled;
+ 
+ public:
+     ExprEngine(std::vector<KeyProgram> p, std::vector<KeyProgram> b)
+         : prim(std::move(p)), back(std::move(b)),
+           lead(THRESHOLD_SEC >= 0.0 ? 1 : 0),
+           nk(lead + prim.size())
+     {
+         for (const KeyProgram& k : prim) {
+             timed |= k.uses_now();
+             st_at.push_back(ns);
+             ns += k.statics();
+         }
+     }
+ 
+     void advance(double) override {}
+ 
+     void submit(SchedJob* j) override
+     {
+         j->aged = false;
+         soa.insert(j);
+         pk.resize(soa.size() * nk);
+         ps.resize(soa.size() * ns);
+ 
+         const uint32_t* h = soa.hosts()+j->pos;
+         const double*   w = soa.walltimes()+j->pos;
+         const double*   s = soa.submit_times()+j->pos;
+         for (size_t k = 0; k < prim.size(); ++k) {
+             if (prim[k].uses_now())
+                 prim[k].eval_statics(h, w, s, 1, ps.data() + j->pos*ns + st_at[k], ns);
+             else
+                 prim[k].eval(h, w, s, 1, j->submit_time, &pk[j->pos*nk + lead + k]);
+         }
+         if (lead) { pk[j->pos*nk] = 1.0; arrivals.push(j); }
+         join_heads(j);
+ 
+         if (settled.valid) {
+             settled.min_width = std::min(settled.min_width, j->nb_hosts);
+             if (j->nb_hosts<=settled.free &&
+                 (j->submit_time+j->walltime<=settled.reserve ||
+                  j->nb_hosts<=settled.extra)) settled.dirty = true;
+         }
+     }
+ 
+     void begin() override { settled.dirty = true; }
+ 
+     void finished(const JobTable<SchedJob>::Running&, double) override
+     {
+         settled.dirty = true;
+     }
+ 
+     void releases_moved() override { settled.dirty = true; }
+ 
+     size_t pending() const override { return soa.size(); }
+ 
+     const SchedJob* head(double) override { return nullptr; }   // never speculates
+ 
+     double next_aging() const override { return arrivals.next_due(THRESHOLD_SEC); }
+ 
+     void decide(double now) override
+     {
+         PhaseTimer order_t(phases.get(), Phase::ORDER);
+         if (lead)
+             arrivals.promote(now, THRESHOLD_SEC, [this](SchedJob* j){
+                 j->aged = true;
+                 pk[j->pos*nk] = 0.0;
+                 if (auto it = std::find(heads.begin(), heads.end(), j); it != heads.end())
+                     heads.erase(it);
+                 join_heads(j);
+             });
+ 
+         if (settled.valid &&
+             (hosts.free_count()<settled.min_width ||
+              (!settled.dirty && !timed && primary_head()==settled.head))) {
+             ++nb_fast; return;
+         }
+         ++nb_passes;
+ 
+         if (timed) { primary_keys(now); heads.clear(); }
+         order_t.stop();
+ 
+         SchedJob* head=nullptr;
+         double reserve_t=now;
+         uint32_t extra=0;
+         bool progress=true;
+         while(progress && !soa.empty()) {
+             progress=false;
+ 
+             head=primary_head();
+ 
+             if (hosts.free_count()>=head->nb_hosts) {
+                 start(head, now);
+                 progress=true; continue;
+             }
+ 
+             reserve_t=compute_reservation(now, head->nb_hosts);
+ 
+             extra=0;
+             if (opts.extra_nodes)
+                 extra=static_cast<uint32_t>(hosts.free_count()+
+                                             profile.released_by(reserve_t)-head->nb_hosts);
+             uint32_t narrow=std::min(extra, hosts.free_count());
+ 
+             /* the jobs that fit now, in backfill order while hosts remain */
+             PhaseTimer t(phases.get(), Phase::BACKFILL);
+             uint32_t min_width=gather(now, reserve_t, narrow);
+             if (cands.empty()) break;
+             const size_t m = cands.size();
+             bk.resize(back.size() * m);
+             for (size_t k = 0; k < back.size(); ++k)
+                 back[k].eval(c_hosts.data(), c_wall.data(), c_submit.data(), m, now, &bk[k*m]);
+             auto after=[&](uint32_t a, uint32_t b){
+                 for (size_t k = 0; k < back.size(); ++k) {
+                     double ka = bk[k*m+a], kb = bk[k*m+b];
+                     if (ka != kb) return ka > kb;
+                 }
+                 return cands[a]->seq > cands[b]->seq;
+             };
+             order.resize(m);
+             for (uint32_t c = 0; c < m; ++c) order[c] = c;
+             std::make_heap(order.begin(), order.end(), after);
+ 
+             while (!order.empty() && hosts.free_count()>=min_width) {
+                 std::pop_heap(order.begin(), order.end(), after);
+                 SchedJob* cand = cands[order.back()];
+                 order.pop_back();
+                 if (hosts.free_count()<cand->nb_hosts) continue;
+                 if (now+cand->walltime>reserve_t) {
+                     if (cand->nb_hosts>extra) continue;
+                     extra-=cand->nb_hosts;            // still running at the shadow time
+                 }
+                 start(cand, now); progress=true;
+                 ++nb_backfilled;
+             }
+         }
+ 
+         settled = Settled();
+         if (!soa.empty()) {
+             settled.valid     = true;
+             settled.head      = head;
+             settled.reserve   = reserve_t;
+             settled.extra     = extra;
+             settled.free      = hosts.free_count();
+             settled.min_width = *std::min_element(soa.hosts(), soa.hosts()+soa.size());
+         }
+     }
+ 
+ private:
+     /* the primary keys that change with time, at `now` */
+     void primary_keys(double now)
+     {
+         const size_t  n = soa.size();
+         const double* s = soa.submit_times();
+         col.resize(n);
+         for (size_t k = 0; k < prim.size(); ++k) {
+             if (!prim[k].uses_now()) continue;
+             double* out = nk == 1 ? pk.data() : col.data();
+             prim[k].eval(soa.hosts(), soa.walltimes(), s, n, now, out,
+                          ps.data() + st_at[k], ns);
+             if (nk > 1) for (size_t i = 0; i < n; ++i) pk[i*nk + lead + k] = col[i];
+         }
+     }
+ 
+     /* heads stays a prefix of the order: j joins it only ahead of its last */
+     void join_heads(SchedJob* j)
+     {
+         if (timed || heads.empty() || !ranks_before(j->pos, heads.back()->pos)) return;
+         auto at = heads.end();
+         while (at != heads.begin() && ranks_before(j->pos, at[-1]->pos)) --at;
+         heads.insert(at, j);
+         if (heads.size() > HEADS) heads.pop_back();
+     }
+ 
+     /* primary order of the entries at a and b */
+     bool ranks_before(uint32_t a, uint32_t b) const
+     {
+         const double* ka = &pk[a*nk];
+         const double* kb = &pk[b*nk];
+         for (size_t k = 0; k < nk; ++k)
+             if (ka[k] != kb[k]) return ka[k] < kb[k];
+         return soa.job(a)->seq < soa.job(b)->seq;
+     }
+ 
+     /* first job of the primary order; heads is refilled by a scan once
+        every job in it has started                                      */
+     SchedJob* primary_head()
+     {
+         if (heads.empty()) {
+             double bound = HUGE_VAL;                  // first key of the last head
+             for (uint32_t i = 0; i < soa.size(); ++i) {
+                 if (pk[i*nk] > bound) continue;
+                 if (heads.size() == HEADS) {
+                     if (!ranks_before(i, heads.back()->pos)) continue;
+                     heads.pop_back();
+                 }
+                 auto at = heads.end();
+                 while (at != heads.begin() && ranks_before(i, at[-1]->pos)) --at;
+                 heads.insert(at, soa.job(i));
+                 if (heads.size() == HEADS) bound = pk[heads.back()->pos*nk];
+             }
+         }
+         return heads.front();
+     }
+ 
+     /* jobs that fit in the free hosts, before the shadow time or in the
+        narrow ones, with their fields copied out; their least width.
+        The test is branch-free: every slot is written, kept or not.      */
+     uint32_t gather(double now, double reserve_t, uint32_t narrow)
+     {
+         const size_t    n = soa.size();
+         const uint32_t* h = soa.hosts();
+         const double*   w = soa.walltimes();
+         const double*   s = soa.submit_times();
+         const uint32_t free = hosts.free_count();
+         order.resize(n + 1);
+         size_t m = 0;
+         for (uint32_t i = 0; i < n; ++i) {
+             order[m] = i;
+             m += (h[i] <= free) & ((now + w[i] <= reserve_t) | (h[i] <= narrow));
+         }
+ 
+         uint32_t least = UINT32_MAX;
+         cands.resize(m); c_hosts.resize(m); c_wall.resize(m); c_submit.resize(m);
+         for (size_t c = 0; c < m; ++c) {
+             uint32_t i = order[c];
+             cands[c] = soa.job(i);
+             c_hosts[c] = h[i]; c_wall[c] = w[i]; c_submit[c] = s[i];
+             least = std::min(least, h[i]);
+         }
+         return least;
+     }
+ 
+     /* launch j and drop it, its rows following the arrays' swap */
+     void start(SchedJob* j, double now)
+     {
+         launch_job(j, now);
+         if (lead && !j->aged) arrivals.erase(j);
+         if (auto it = std::find(heads.begin(), heads.end(), j); it != heads.end())
+             heads.erase(it);
+         size_t last = soa.size() - 1;
+         if (j->pos != last) {
+             std::copy_n(pk.data() + last*nk, nk, pk.data() + j->pos*nk);
+             std::copy_n(ps.data() + last*ns, ns, ps.data() + j->pos*ns);
+         }
+         pk.resize(last * nk);
+         ps.resize(last * ns);
+         soa.erase(j);
+     }
+ };
+ 
+ /* engine over expression keys, nullptr (with a message) if one does not compile */
+ static std::unique_ptr<Engine> make_expr_engine(const std::string& p, const std::string& b)
+ {
+     std::vector<KeyProgram> pk, bk;
+     std::string err;
+     if (!compile_keys(p, pk, err, true) || !compile_keys(b, bk, err)) {
+         fprintf(stderr, "easy-unified: bad queue key %s\n", err.c_str());
+         return nullptr;
+     }
+     return std::make_unique<ExprEngine>(std::move(pk), std::move(bk));
+ }
+ 
+ /* the 7 × 7 × 2 EASY and as many reserving instantiations, picked by value;
+    depth 1 is plain EASY                                                   */
+ template <Policy P, Policy B>
+ static std::unique_ptr<Engine> make_engine(bool threshold, size_t depth)
+ {
+     if (depth > 1) {
+         if (threshold) return std::make_unique<ReservingEngine<P, B, true>>(depth);
+         return std::make_unique<ReservingEngine<P, B, false>>(depth);
+     }
+     if (threshold) return std::make_unique<EasyEngine<P, B, true>>();
+     return std::make_unique<EasyEngine<P, B, false>>();
+ }
+ 
+ template <Policy P>
+ static std::unique_ptr<Engine> make_engine(Policy b, bool threshold, size_t depth)
+ {
+     switch (b) {
+         case Policy::EXP : return make_engine<P, Policy::EXP >(threshold, depth);
+         case Policy::FCFS: return make_engine<P, Policy::FCFS>(threshold, depth);
+         case Policy::LCFS: return make_engine<P, Policy::LCFS>(threshold, depth);
+         case Policy::LPF : return make_engine<P, Policy::LPF >(threshold, depth);
+         case Policy::LQF : return make_engine<P, Policy::LQF >(threshold, depth);
+         case Policy::SPF : return make_engine<P, Policy::SPF >(threshold, depth);
+         case Policy::SQF : return make_engine<P, Policy::SQF >(threshold, depth);
+     }
+     return nullptr;
+ }
+ 
+ static std::unique_ptr<Engine> make_engine(Policy p, Policy b, bool threshold, size_t depth)
  {
      switch (p) {
-         case Policy::FCFS: return  j->submit_time;
-         case Policy::LCFS: return -j->submit_time;
-         case Policy::SQF : return  j->nb_hosts;
-         case Policy::LQF : return -static_cast<double>(j->nb_hosts);
-         case Policy::SPF : return  j->walltime;
-         case Policy::LPF : return -j->walltime;
-         case Policy::EXP : return -( (now - j->submit_time + j->walltime) /
-                                      j->walltime );
+         case Policy::EXP : return make_engine<Policy::EXP >(b, threshold, depth);
+         case Policy::FCFS: return make_engine<Policy::FCFS>(b, threshold, depth);
+         case Policy::LCFS: return make_engine<Policy::LCFS>(b, threshold, depth);
+         case Policy::LPF : return make_engine<Policy::LPF >(b, threshold, depth);
+         case Policy::LQF : return make_engine<Policy::LQF >(b, threshold, depth);
+         case Policy::SPF : return make_engine<Policy::SPF >(b, threshold, depth);
+         case Policy::SQF : return make_engine<Policy::SQF >(b, threshold, depth);
      }
-     return 0;
+     return nullptr;
  }
  
+ static std::unique_ptr<Engine> engine;
+ 
  /* ------------------------------------------------------------------------- */
- /* helpers                                                                   */
- static double compute_reservation(double now, uint32_t need)
+ /*  #spec: killed jobs run again (speculation.hpp)                           */
+ /* registered under a new id as the same job (hosts, walltime, profile)
+    and queued with its first submission time and rank                  */
+ static void requeue(JobHandle old)
  {
-     uint32_t free = available_hosts.size();
-     if (free >= need) return now;
+     SchedJob was = jobs.record(old);
+     const std::string& id = spec.requeue_id(jobs.id(old), was.runs);
+     jobs.retire(old);
+     JobHandle h = jobs.intern(id);
+     SchedJob* j = &jobs.record(h);
+     *j = was;
+     j->h       = h;
+     j->kill_at = HUGE_VAL;
+     jobs.running(h).hosts.reserve(std::min(j->nb_hosts, HOST_RANGES_RESERVED));
  
-     std::vector<std::pair<double,uint32_t>> events;
-     for (auto& kv : end_times)
-         events.emplace_back(kv.second, allocations[kv.first].size());
-     std::sort(events.begin(), events.end());
+     auto job = Job::make();
+     job->set_resource_number(j->nb_hosts);
+     job->set_walltime(j->req_walltime);
+     job->set_profile(spec.profile(j->profile));
+     mb->add_register_job(id, job);
+     engine->submit(j);
+ }
  
-     for (auto& ev : events) {
-         free += ev.second;
-         if (free >= need) return ev.first;
-     }
-     return events.empty() ? now : events.back().first;
+ /* ------------------------------------------------------------------------- */
+ /*  #adapt: queue orders picked by what-if replays (order_adapter.hpp)       */
+ static OrderAdapter adapter;
+ 
+ /* running and pending jobs as the replays see them */
+ static std::shared_ptr<const WhatIfSnapshot> take_snapshot(double now)
+ {
+     RuntimePredictor* pr = predictor ? predictor.get() : side_predictor.get();
+     auto snap = std::make_shared<WhatIfSnapshot>();
+     snap->now  = now;
+     snap->free = hosts.free_count();
+     jobs.for_each([&](JobHandle h){
+         const SchedJob& j = jobs.record(h);
+         const JobTable<SchedJob>::Running& run = jobs.running(h);
+         double runtime = pr->predict(j.nb_hosts, j.req_walltime);
+         if (run.active) {
+             double end = run.start + runtime;
+             if (end <= now) end = run.start + j.req_walltime;     // outlived its prediction
+             snap->releases.emplace_back(std::max(end, now), run.nb_hosts);
+         } else
+             snap->pending.push_back(WhatIfJob{j.nb_hosts, runtime, j.submit_time, j.seq});
+     });
+     std::sort(snap->releases.begin(), snap->releases.end());
+     std::sort(snap->pending.begin(), snap->pending.end(),
+               [](const WhatIfJob& a, const WhatIfJob& b){ return a.seq < b.seq; });
+     return snap;
  }
  
- static std::string allocate(const std::string& jid, uint32_t q)
+ /* rebuild the engine for `to` and hand it the pending jobs */
+ static void switch_orders(const OrderPair& to, double now)
  {
-     auto it = available_hosts.begin();
-     std::set<uint32_t> picked;
-     for (uint32_t i=0;i<q;++i,++it) picked.insert(*it);
-     for (uint32_t h:picked) available_hosts.erase(h);
-     allocations[jid] = picked;
+     std::vector<SchedJob*> waiting;
+     OrderAdapter::waiting(jobs, waiting);
+     engine = make_engine(to.p, to.b, THRESHOLD_SEC >= 0.0, 1);
+     engine->begin();
+     engine->advance(now);
+     for (SchedJob* j : waiting) engine->submit(j);
+ }
  
-     std::string s;
-     for (auto h_it=picked.begin(); h_it!=picked.end(); ++h_it) {
-         if (h_it!=picked.begin()) s += ",";
-         s += std::to_string(*h_it);
-     }
-     return s;
+ static void adapt(double now)
+ {
+     WhatIfParams prm;
+     prm.threshold   = THRESHOLD_SEC;
+     prm.extra_nodes = opts.extra_nodes;
+     prm.metric      = opts.target;
+     if (const OrderPair* to = adapter.evaluate(now, engine->pending(), prm,
+                                                [now]{ return take_snapshot(now); }))
+         switch_orders(*to, now);
  }
  
  /* ------------------------------------------------------------------------- */
@@ -123,7 +1326,6 @@
  {
      format_bin = (flags & BATSIM_EDC_FORMAT_BINARY);
      mb      = new MessageBuilder(!format_bin);
-     pending = new std::list<SchedJob*>();
  
      /* parse argument */
      if (arg && arg_sz) {
@@ -131,6 +1333,54 @@
          s.erase(remove_if(s.begin(), s.end(),
                            [](char c){return c=='\''||c=='\"';}), s.end());
  
+         size_t hash = s.find('#');
+         if (hash != std::string::npos) {
+             std::string opt_part = s.substr(hash+1);
+             s.erase(hash);
+             size_t b = 0;
+             while (b <= opt_part.size()) {
+                 size_t e = opt_part.find('#', b);
+                 if (e == std::string::npos) e = opt_part.size();
+                 std::string o = opt_part.substr(b, e-b);
+                 if      (o == "extra") opts.extra_nodes  = true;
+                 else if (o == "cons")  opts.conservative = true;
+                 else if (o == "los")   opts.lookahead    = true;
+                 else if (o == "spec")  opts.speculative  = true;
+                 else if (o == "pred")  opts.predictor    = "avg";
+                 else if (o.compare(0, 5, "pred=") == 0) opts.predictor = o.substr(5);
+                 else if (o == "adapt") opts.adapt = "*";
+                 else if (o.compare(0, 6, "adapt=") == 0) opts.adapt = o.substr(6);
+                 else if (o == "target=wait")    opts.target = WhatIfMetric::WAIT;
+                 else if (o == "target=maxwait") opts.target = WhatIfMetric::MAX_WAIT;
+                 else if (o == "target=bsld")    opts.target = WhatIfMetric::BSLD;
+                 else if (o == "prof")  opts.profile = "out/easy-unified-phases";
+                 else if (o.compare(0, 5, "prof=") == 0 && o.size() > 5) opts.profile = o.substr(5);
+                 else if (o == "perf")  opts.perf = true;
+                 else if (o == "trace") opts.trace = "out/easy-unified-trace.json";
+                 else if (o.compare(0, 6, "trace=") == 0 && o.size() > 6) opts.trace = o.substr(6);
+                 else if (o == "live")  opts.live = "/easy-live";
+                 else if (o.compare(0, 5, "live=") == 0 && o.size() > 5)
+                     opts.live = (o[5] == '/' ? "" : "/") + o.substr(5);
+                 else if (o.compare(0, 5, "tune=") == 0 && std::strtod(o.c_str()+5, nullptr) > 0)
+                     opts.tune_p99 = std::strtod(o.c_str()+5, nullptr) * 3600.0;   // h→s
+                 else if (o.size() > 1 && o[0] == 'k' && isdigit((unsigned char)o[1])) {
+                     /* no std::stoul: an exception must not cross the C interface */
+                     char* end = nullptr;
+                     errno = 0;
+                     unsigned long k = std::strtoul(o.c_str()+1, &end, 10);
+                     if (*end || errno == ERANGE || k == 0 || k > MAX_DEPTH) {
+                         fprintf(stderr, "easy-unified: bad reservation depth '#%s' "
+                                         "(1 to %zu, #cons beyond)\n", o.c_str(), MAX_DEPTH);
+                         return 1;
+                     }
+                     opts.depth = k;
+                 }
+                 else if (!o.empty())
+                     fprintf(stderr, "easy-unified: unknown option '#%s'\n", o.c_str());
+                 b = e+1;
+             }
+         }
+ 
          size_t at = s.find('@');
          std::string queue_part = (at==std::string::npos)? s : s.substr(0,at);
          if (at != std::string::npos)
@@ -142,17 +1392,151 @@
          std::string p2 = (comma==std::string::npos)? p1
                                                     : queue_part.substr(comma+1);
          if (auto it=STR2POL.find(p1); it!=STR2POL.end()) primary_policy=it->second;
+         else primary_expr=p1;
          if (auto it=STR2POL.find(p2); it!=STR2POL.end()) backfill_policy=it->second;
+         else backfill_expr=p2;
+     }
+ 
+     if (opts.tune_p99 > 0 && THRESHOLD_SEC < 0.0) THRESHOLD_SEC = opts.tune_p99;
+     tuner.set_target(opts.tune_p99);
+ 
+     size_t depth = opts.conservative ? SIZE_MAX : opts.depth;
+     if (!primary_expr.empty() || !backfill_expr.empty()) {
+         if (depth > 1 || opts.lookahead) {
+             fprintf(stderr, "easy-unified: #cons, #kN and #los ignored with expression keys\n");
+             depth = 1;
+         }
+         engine = make_expr_engine(
+             primary_expr.empty()  ? policy_expression(primary_policy)  : primary_expr,
+             backfill_expr.empty() ? policy_expression(backfill_policy) : backfill_expr);
+     }
+     if (!engine)
+         engine = make_engine(primary_policy, backfill_policy, THRESHOLD_SEC >= 0.0, depth);
+ 
+     if (!opts.predictor.empty()) {
+         predictor = make_predictor(opts.predictor);
+         if (!predictor)
+             fprintf(stderr, "easy-unified: unknown predictor '%s'\n", opts.predictor.c_str());
+         else if (depth > 1) {
+             /* reservations there are guarantees: keep the walltimes */
+             fprintf(stderr, "easy-unified: #pred ignored with reservations beyond the head\n");
+             predictor.reset();
+         }
+     }
+ 
+     if (!opts.adapt.empty()) {
+         if (depth > 1)
+             fprintf(stderr, "easy-unified: #adapt ignored with reservations beyond the head\n");
+         else if (!primary_expr.empty() || !backfill_expr.empty())
+             fprintf(stderr, "easy-unified: #adapt ignored with expression keys\n");
+         else if (!adapter.set_pairs(OrderPair{primary_policy, backfill_policy}, opts.adapt))
+             fprintf(stderr, "easy-unified: bad #adapt list '%s'\n", opts.adapt.c_str());
+     }
+ 
+     if (opts.speculative) {
+         const char* why = depth > 1 ? "reservations beyond the head"
+                         : !primary_expr.empty() || !backfill_expr.empty() ? "expression keys"
+                         : predictor ? "#pred (it plans on predictions already)" : nullptr;
+         if (opts.lookahead) {
+             /* LOS picks its own subset and never speculates */
+             fprintf(stderr, "easy-unified: #spec cannot be combined with #los\n");
+             return 1;
+         }
+         if (why) {
+             fprintf(stderr, "easy-unified: #spec ignored with %s\n", why);
+             opts.speculative = false;
+         }
+     }
+     if (!predictor && (opts.speculative || adapter.on()))
+         side_predictor = make_predictor("avg");
+     if (opts.perf && opts.profile.empty()) opts.profile = "out/easy-unified-phases";
+     if (!opts.profile.empty() || !opts.trace.empty()) phases = std::make_unique<PhaseProfile>();
+     if (opts.perf) {
+         counters = std::make_unique<PerfCounters>();
+         if (counters->available()) phases->count_with(counters.get());
+         else fprintf(stderr, "easy-unified: hardware counters unavailable (%s), timing only\n",
+                      counters->reason().c_str());
+     }
+     if (!opts.trace.empty()) {
+         tracer = std::make_unique<TraceWriter>(opts.trace, trace_names());
+         if (tracer->ok()) phases->trace_to(tracer.get());
+         else {
+             fprintf(stderr, "easy-unified: cannot write the trace '%s'\n", opts.trace.c_str());
+             tracer.reset();
+         }
+     }
+     if (!opts.live.empty()) {
+         telemetry = std::make_unique<LiveWriter>(opts.live);
+         if (!telemetry->ok()) {
+             fprintf(stderr, "easy-unified: cannot open the telemetry ring '%s' (%s)\n",
+                     opts.live.c_str(), telemetry->reason().c_str());
+             telemetry.reset();
+         }
      }
      return 0;
  }
  
  extern "C" uint8_t batsim_edc_deinit()
  {
-     delete mb;
-     for (auto*j:*pending) delete j;
-     delete pending;
-     allocations.clear(); end_times.clear(); available_hosts.clear();
+     const SlabStats& st = jobs.stats();
+     printf("easy-unified: job records acquired=%llu recycled=%llu released=%llu "
+            "live=%zu peak=%zu chunks=%zu\n",
+            (unsigned long long)st.acquired, (unsigned long long)st.recycled,
+            (unsigned long long)st.released, st.live, st.peak, st.chunks);
+     printf("easy-unified: calls=%llu passes=%llu fast-path=%llu\n",
+            (unsigned long long)nb_calls, (unsigned long long)nb_passes,
+            (unsigned long long)nb_fast);
+     if (predictor) prediction_repair.report("easy-unified", opts.predictor.c_str());
+     if (adapter.on()) adapter.report("easy-unified");
+     if (opts.lookahead)
+         printf("easy-unified: los selections=%llu on-blocks=%llu\n",
+                (unsigned long long)nb_los, (unsigned long long)nb_los_coarse);
+     if (opts.speculative) spec.report("easy-unified");
+     if (tuner.on()) tuner.report("easy-unified", THRESHOLD_SEC);
+     if constexpr (counting_allocs) {
+         for (const auto* t : {&alloc_stats.with_submissions, &alloc_stats.without})
+             printf("easy-unified: allocations in calls %s submissions: calls=%llu allocating=%llu "
+                    "total=%llu max=%llu\n", t == &alloc_stats.without ? "without" : "with",
+                    (unsigned long long)t->calls, (unsigned long long)t->allocating,
+                    (unsigned long long)t->total, (unsigned long long)t->max);
+         alloc_stats = AllocStats();
+     }
+     if (tracer)
+         printf("easy-unified: trace events=%llu dropped=%llu\n",
+                (unsigned long long)tracer->written(), (unsigned long long)tracer->dropped());
+     if (telemetry)
+         printf("easy-unified: live samples=%llu\n", (unsigned long long)telemetry->published());
+     std::string hw = !counters ? "off"
+                    : counters->available() ? "on" : "unavailable: " + counters->reason();
+     if (!opts.profile.empty() && phases && !phases->write(opts.profile, hw))
+         fprintf(stderr, "easy-unified: cannot write the phase report '%s.json/.csv'\n",
+                 opts.profile.c_str());
+ 
+     delete mb; mb = nullptr;
+     engine.reset();
+     opts = Options();
+     primary_policy = backfill_policy = Policy::FCFS;
+     primary_expr.clear(); backfill_expr.clear();
+     THRESHOLD_SEC = -1.0;
+     platform_nb_hosts = 0;
+     next_seq = 0;
+     nb_calls = nb_passes = nb_fast = 0;
+     predictor.reset();
+     side_predictor.reset();
+     spec.clear();
+     adapter.clear();
+     aging_wake = -1;
+     nb_wakes = 0; wake_id = std::string();
+     tuner.clear();
+     tracer.reset();
+     phases.reset();
+     counters.reset();
+     telemetry.reset();
+     nb_started = nb_backfilled = 0;
+     nb_los = nb_los_coarse = 0;
+     prediction_repair.clear();
+     jobs.clear(); hosts.reset(0);
+     profile.clear();
      return 0;
  }
  
@@ -160,94 +1544,150 @@
  batsim_edc_take_decisions(const uint8_t *what, uint32_t,
                            uint8_t **decisions, uint32_t *dsz)
  {
+     const uint64_t allocs_before = allocations();
+     const uint64_t call_start    = telemetry ? TraceWriter::clock_ns() : 0;
+     bool submitted = false;           // jobs joined the queues
+     PhaseTimer call_t(phases.get(), Phase::CALL);
+     PhaseTimer lap(phases.get(), Phase::DESERIALIZE);
+     if (phases) phases->set_depth(engine->pending());
      auto *msg = deserialize_message(*mb, !format_bin, what);
      double now = msg->now();
+     if (phases) phases->set_now(now);
      mb->clear(now);
+     engine->advance(now);
+     ++nb_calls;
  
      /* events */
+     lap.next(Phase::EVENTS);
      for (auto *ev : *msg->events()) {
          switch(ev->event_type()) {
-             case fb::Event_BatsimHelloEvent:
-                 mb->add_edc_hello("easy-unified", "1.2"); break;
+             case fb::Event_BatsimHelloEvent: {
+                 /* #spec registers the jobs it kills again, on their profiles */
+                 std::shared_ptr<EDCHelloOptions> hello;
+                 if (opts.speculative) {
+                     hello = EDCHelloOptions::make();
+                     hello->request_dynamic_registration();
+                     hello->request_profile_reuse();
+                 }
+                 mb->add_edc_hello("easy-unified", "1.3", hello);
+                 break;
+             }
  
              case fb::Event_SimulationBeginsEvent: {
                  auto b = ev->event_as_SimulationBeginsEvent();
                  platform_nb_hosts = b->computation_host_number();
-                 for (uint32_t i=0;i<platform_nb_hosts;++i) available_hosts.insert(i);
+                 hosts.reset(platform_nb_hosts);
+                 if (telemetry) telemetry->set_nb_hosts(platform_nb_hosts);
+                 engine->begin();
                  break;
              }
              case fb::Event_JobSubmittedEvent: {
                  auto s = ev->event_as_JobSubmittedEvent();
-                 auto *j = new SchedJob();
-                 j->job_id      = s->job_id()->str();
-                 j->nb_hosts    = s->job()->resource_request();
-                 j->walltime    = s->job()->walltime();
-                 j->submit_time = now;
-                 if (j->nb_hosts>platform_nb_hosts)
-                     mb->add_reject_job(j->job_id), delete j;
-                 else pending->push_back(j);
+                 if (s->job()->resource_request()>platform_nb_hosts) {
+                     mb->add_reject_job(s->job_id()->str()); break;
+                 }
+                 JobHandle h     = jobs.intern(s->job_id()->str());
+                 SchedJob* j     = &jobs.record(h);
+                 j->h            = h;
+                 j->nb_hosts     = s->job()->resource_request();
+                 jobs.running(h).hosts.reserve(std::min(j->nb_hosts, HOST_RANGES_RESERVED));
+                 j->req_walltime = s->job()->walltime();
+                 j->walltime     = predictor ? predictor->predict(j->nb_hosts, j->req_walltime)
+                                             : j->req_walltime;
+                 j->submit_time  = now;
+                 j->seq          = next_seq++;
+                 j->guess        = opts.speculative ? side_predictor->bound(j->nb_hosts, j->req_walltime)
+                                                    : j->walltime;
+                 j->kill_at      = HUGE_VAL;
+                 if (opts.speculative) {
+                     j->profile  = spec.profile_index(s->job()->profile_id()->str());
+                     j->runs     = 0;
+                 }
+                 engine->submit(j);
+                 submitted = true;
                  break;
              }
              case fb::Event_JobCompletedEvent: {
                  auto c=ev->event_as_JobCompletedEvent();
-                 auto jid=c->job_id()->str();
-                 if (allocations.count(jid)) {
-                     for(uint32_t h:allocations[jid]) available_hosts.insert(h);
-                     allocations.erase(jid); end_times.erase(jid);
+                 JobHandle h=jobs.lookup(c->job_id()->str());
+                 if (jobs.alive(h) && jobs.running(h).active) {
+                     JobTable<SchedJob>::Running& run=jobs.running(h);
+                     const SchedJob& rec=jobs.record(h);
+                     RuntimePredictor* pr = predictor ? predictor.get() : side_predictor.get();
+                     if (pr) pr->learn(rec.nb_hosts, rec.req_walltime, now-run.start);
+                     if (rec.kill_at != HUGE_VAL) spec.completed((now-run.start) * run.nb_hosts);
+                     profile.remove(run.end, run.nb_hosts);
+                     hosts.release(run.hosts);
+                     engine->finished(run, now);
+                     jobs.retire(h);
                  }
                  break;
              }
+             case fb::Event_JobsKilledEvent: {
+                 /* #spec: the hosts come back, and the job queues again */
+                 for (auto *id : *ev->event_as_JobsKilledEvent()->job_ids()) {
+                     JobHandle h=jobs.lookup(id->str());
+                     if (!jobs.alive(h) || !jobs.running(h).active) continue;
+                     JobTable<SchedJob>::Running& run=jobs.running(h);
+                     spec.killed((now-run.start) * run.nb_hosts);
+                     profile.remove(run.end, run.nb_hosts);
+                     hosts.release(run.hosts);
+                     engine->finished(run, now);
+                     requeue(h);
+                     submitted = true;
+                 }
+                 break;
+             }
+             case fb::Event_AllStaticJobsHaveBeenSubmittedEvent:
+                 spec.all_submitted(); break;
              default: break;
          }
      }
  
-     /* EASY loop */
-     bool progress=true;
-     while(progress && !pending->empty()) {
-         progress=false;
- 
-         /* unified sort: old jobs first, then policy */
-         pending->sort([&](SchedJob* a,SchedJob* b){
-             bool a_old = (THRESHOLD_SEC >= 0.0) &&
-                          ((now - a->submit_time) > THRESHOLD_SEC);
-             bool b_old = (THRESHOLD_SEC >= 0.0) &&
-                          ((now - b->submit_time) > THRESHOLD_SEC);
-             if (a_old != b_old)
-                 return a_old;                       // old before new
-             return key_for(a,now,primary_policy) < key_for(b,now,primary_policy);
-         });
- 
-         SchedJob* head=pending->front();
- 
-         if (available_hosts.size()>=head->nb_hosts) {
-             auto res=allocate(head->job_id, head->nb_hosts);
-             mb->add_execute_job(head->job_id,res);
-             end_times[head->job_id]=now+head->walltime;
-             pending->pop_front(); progress=true; continue;
-         }
- 
-         double reserve_t=compute_reservation(now, head->nb_hosts);
+     lap.next(Phase::CONTROL);
+     if (phases) phases->set_depth(engine->pending());
+     auto wake = [](const char* kind){ return [kind](double t){ request_call(kind, t); }; };
+     if (predictor && prediction_repair.repair(now, jobs, profile, wake("pred-expiry")))
+         engine->releases_moved();
+     if (opts.speculative) {
+         const SchedJob* head = engine->head(now);
+         auto kill = [](const std::vector<std::string>& ids){ mb->add_kill_jobs(ids); };
+         if (spec.kill_overruns(now, jobs, profile, hosts.free_count(), head ? head->nb_hosts : 0,
+                                kill, wake("spec-kill")))
+             engine->releases_moved();
+     }
  
-         std::vector<SchedJob*> bf(std::next(pending->begin()), pending->end());
-         std::sort(bf.begin(), bf.end(), [&](SchedJob* a,SchedJob* b){
-             return key_for(a,now,backfill_policy) < key_for(b,now,backfill_policy);
-         });
+     if (tuner.on() && tuner.due(now))
+         THRESHOLD_SEC = tuner.tune(now, THRESHOLD_SEC, [now](auto add){
+             jobs.for_each([&](JobHandle h){
+                 if (!jobs.running(h).active) add(now - jobs.record(h).submit_time);
+             });
+         }, "easy-unified");
+     if (adapter.on() && adapter.due(now)) adapt(now);
  
-         for(SchedJob* cand:bf){
-             if(available_hosts.size()>=cand->nb_hosts &&
-                now+cand->walltime<=reserve_t)
-             {
-                 auto res=allocate(cand->job_id,cand->nb_hosts);
-                 mb->add_execute_job(cand->job_id,res);
-                 end_times[cand->job_id]=now+cand->walltime;
-                 pending->remove(cand); progress=true;
-             }
-         }
+     /* EASY loop */
+     lap.next(Phase::DECIDE);
+     engine->decide(now);
+     request_aging_wake(engine->next_aging());
+     if (opts.speculative && spec.may_close(engine->pending())) {
+         mb->add_finish_registration();      // nothing left that could be killed
+         spec.close();
+     }
+     if (phases) {
+         phases->count(Counter::PENDING, engine->pending());
+         phases->count(Counter::FREE_HOSTS, hosts.free_count());
      }
  
+     lap.next(Phase::SERIALIZE);
      mb->finish_message(now);
      serialize_message(*mb, !format_bin,
                        const_cast<const uint8_t **>(decisions), dsz);
+     if (telemetry)
+         telemetry->publish(LiveSample{now, nb_calls, nb_started, nb_backfilled,
+                                       TraceWriter::clock_ns() - call_start,
+                                       static_cast<uint32_t>(engine->pending()),
+                                       hosts.free_count()});
+     if constexpr (counting_allocs) alloc_stats.add(allocations() - allocs_before, submitted);
      return 0;
  }
  
\ No newline at end of file
@@ -0,0 +1,131 @@
+/**************************************************************
+ *  host_pool.hpp  —  free hosts as a two-level bitmap
+ *
+ *  Level 0 has one bit per host (1 = free), level 1 one bit per
+ *  level-0 word that still has a free host.  claim() takes the
+ *  q lowest free hosts, like walking a std::set from begin(),
+ *  but a whole word at a time with ctz/popcount, and returns
+ *  them as closed intervals.  to_string() prints intervals in
+ *  IntervalSet::to_string_hyphen() form ("0-3,8,10-12"), into a
+ *  buffer the caller may reuse.
+ *************************************************************/
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct HostRange {
+    uint32_t first, last;     // closed interval
+};
+using HostAlloc = std::vector<HostRange>;
+
+class HostPool {
+public:
+    /* n hosts, all free */
+    void reset(uint32_t n)
+    {
+        nb   = n;
+        nfree = n;
+        bits.assign((n + 63) / 64, ~0ull);
+        if (n % 64) bits.back() = (1ull << (n % 64)) - 1;
+        summary.assign((bits.size() + 63) / 64, 0);
+        for (size_t w = 0; w < bits.size(); ++w)
+            if (bits[w]) summary[w / 64] |= 1ull << (w % 64);
+    }
+
+    uint32_t size()       const { return nb; }
+    uint32_t free_count() const { return nfree; }
+
+    /* take the q lowest free hosts (q <= free_count()) */
+    void claim(uint32_t q, HostAlloc& out)
+    {
+        out.clear();
+        nfree -= q;
+        for (size_t s = 0; q > 0 && s < summary.size(); ++s) {
+            while (q > 0 && summary[s]) {
+                size_t   w    = s * 64 + ctz(summary[s]);
+                uint64_t word = bits[w];
+                uint64_t take = word;
+                uint32_t cnt  = popcount(word);
+                if (cnt > q) { take = lowest_bits(word, q); cnt = q; }
+
+                bits[w] &= ~take;
+                if (!bits[w]) summary[s] &= summary[s] - 1;
+                q -= cnt;
+                push_runs(out, static_cast<uint32_t>(w * 64), take);
+            }
+        }
+    }
+
+    void release(const HostAlloc& a)
+    {
+        for (const HostRange& r : a) {
+            nfree += r.last - r.first + 1;
+            for (uint32_t h = r.first; h <= r.last;) {
+                uint32_t w  = h / 64, lo = h % 64;
+                uint32_t hi = (r.last / 64 == w) ? r.last % 64 : 63;
+                uint64_t m  = (hi == 63 ? ~0ull : ((1ull << (hi + 1)) - 1)) & (~0ull << lo);
+                bits[w] |= m;
+                summary[w / 64] |= 1ull << (w % 64);
+                h = w * 64 + hi + 1;
+            }
+        }
+    }
+
+    static uint32_t count(const HostAlloc& a)
+    {
+        uint32_t n = 0;
+        for (const HostRange& r : a) n += r.last - r.first + 1;
+        return n;
+    }
+
+    static void to_string(const HostAlloc& a, std::string& s)
+    {
+        s.clear();
+        for (const HostRange& r : a) {
+            if (!s.empty()) s += ',';
+            append_uint(s, r.first);
+            if (r.last != r.first) { s += '-'; append_uint(s, r.last); }
+        }
+    }
+
+private:
+    uint32_t              nb = 0, nfree = 0;
+    std::vector<uint64_t> bits;      // 1 bit per host
+    std::vector<uint64_t> summary;   // 1 bit per non-empty word of `bits`
+
+    static void append_uint(std::string& s, uint32_t v)
+    {
+        char buf[10];
+        int  n = 0;
+        do { buf[n++] = char('0' + v % 10); v /= 10; } while (v);
+        while (n) s += buf[--n];
+    }
+
+    static uint32_t ctz(uint64_t x)      { return __builtin_ctzll(x); }
+    static uint32_t popcount(uint64_t x) { return __builtin_popcountll(x); }
+
+    /* the q lowest set bits of x (q < popcount(x)) */
+    static uint64_t lowest_bits(uint64_t x, uint32_t q)
+    {
+        uint64_t rest = x;
+        for (uint32_t i = 0; i < q; ++i) rest &= rest - 1;
+        return x & ~rest;
+    }
+
+    /* append the runs of set bits of m (word starting at host base),
+       merging with the last interval when contiguous */
+    static void push_runs(HostAlloc& out, uint32_t base, uint64_t m)
+    {
+        while (m) {
+            uint32_t lo  = ctz(m);
+            uint64_t sh  = m >> lo;
+            uint32_t len = (~sh == 0) ? 64 - lo : ctz(~sh);
+            uint32_t first = base + lo, last = first + len - 1;
+            if (!out.empty() && out.back().last + 1 == first) out.back().last = last;
+            else out.push_back(HostRange{first, last});
+            m = (lo + len >= 64) ? 0 : (m & ~(((1ull << len) - 1) << lo));
+        }
+    }
+};
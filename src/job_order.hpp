@@ -0,0 +1,111 @@
+/**************************************************************
+ *  job_order.hpp  —  persistent ordered index over queued jobs
+ *
+ *  Jobs are ordered by (static key, arrival seq).  The key is
+ *  evaluated once at insertion, so the policy must not depend on
+ *  the current time (EXP is handled elsewhere).  The arrival
+ *  sequence reproduces the tie order of a stable sort of the
+ *  submission-ordered queue.
+ *
+ *      insert / erase     O(log n)
+ *      move_to            O(log n), the tree node goes along
+ *      front / back       O(1)
+ *      in-order walk      O(1) per job
+ *
+ *  The key is either a type with a static key(const Job*) (fixed
+ *  at compile time) or, with Key = void, a function pointer given
+ *  at run time.  Job must expose a `uint64_t seq` member.
+ *
+ *  Erased tree nodes are kept and refilled by later inserts, so
+ *  once the order has held its peak number of jobs it no longer
+ *  allocates.
+ *************************************************************/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <set>
+#include <type_traits>
+#include <vector>
+
+template <class Job, class Key = void>
+class JobOrder {
+public:
+    using KeyFn = double (*)(const Job*);
+
+    struct Entry {
+        double   key;
+        uint64_t seq;
+        Job     *job;
+        bool operator<(const Entry& o) const
+        {
+            return key < o.key || (key == o.key && seq < o.seq);
+        }
+    };
+    using const_iterator = typename std::set<Entry>::const_iterator;
+
+    explicit JobOrder(KeyFn k = nullptr) : key_fn(k) {}
+
+    /* only valid while empty */
+    void set_key(KeyFn k) { key_fn = k; }
+
+    void insert(Job* j) { insert(j, *this); }
+
+    /* insert j into a node `from` (this or another order) freed, if any */
+    void insert(Job* j, JobOrder& from)
+    {
+        std::vector<Node>& src = from.spare.empty() ? spare : from.spare;
+        if (src.empty()) { entries.insert(Entry{key(j), j->seq, j}); make_room(); return; }
+        Node n = std::move(src.back());
+        src.pop_back();
+        n.value() = Entry{key(j), j->seq, j};
+        entries.insert(std::move(n));
+        make_room();
+    }
+
+    void erase(Job* j)
+    {
+        Node n = entries.extract(Entry{key(j), j->seq, j});
+        if (n) spare.push_back(std::move(n));
+    }
+
+    /* erase j and insert it into `to`, without allocating */
+    void move_to(Job* j, JobOrder& to)
+    {
+        Node n = entries.extract(Entry{key(j), j->seq, j});
+        if (!n) return;
+        n.value() = Entry{to.key(j), j->seq, j};
+        to.entries.insert(std::move(n));
+        to.make_room();
+    }
+
+    Job*   front() const { return entries.empty() ? nullptr : entries.begin()->job; }
+    Job*   back()  const { return entries.empty() ? nullptr : entries.rbegin()->job; }
+    bool   empty() const { return entries.empty(); }
+    size_t size()  const { return entries.size(); }
+    void   clear()       { entries.clear(); spare.clear(); }
+
+    const_iterator begin() const { return entries.begin(); }
+    const_iterator end()   const { return entries.end(); }
+
+private:
+    KeyFn           key_fn;
+
+    double key(const Job* j) const
+    {
+        if constexpr (std::is_void_v<Key>) return key_fn(j);
+        else                               return Key::key(j);
+    }
+
+    using Node = typename std::set<Entry>::node_type;
+
+    /* room in spare for every node held, so that erase() never allocates */
+    void make_room()
+    {
+        size_t held = entries.size() + spare.size();
+        if (spare.capacity() < held) spare.reserve(2 * held);
+    }
+
+    std::set<Entry>   entries;
+    std::vector<Node> spare;           // erased nodes, for the next inserts
+};
@@ -0,0 +1,125 @@
+/**************************************************************
+ *  job_table.hpp  —  job ids interned into dense handles, with
+ *                    each job's record and running state in the
+ *                    same pooled slot
+ *
+ *  A Batsim job id is hashed once when the job is submitted and
+ *  once when it completes; everything in between refers to the
+ *  job by a JobHandle {slot index, generation}.  Slots live in a
+ *  SlabPool: addresses are stable (queues may hold pointers to
+ *  records) and a slot is recycled as soon as its job is gone,
+ *  with its generation bumped so stale handles are detected.
+ *************************************************************/
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <queue>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "host_pool.hpp"
+#include "slab_pool.hpp"
+
+struct JobHandle {
+    uint32_t idx = UINT32_MAX;
+    uint32_t gen = 0;
+    bool valid() const { return idx != UINT32_MAX; }
+};
+
+/* a job due at instant t (a predicted end, a kill instant) */
+struct Expiry {
+    double    t;
+    JobHandle h;
+    bool operator>(const Expiry& o) const { return t > o.t; }
+};
+
+/* earliest first; entries of jobs gone or changed since are the
+   reader's to skip                                               */
+using ExpiryQueue = std::priority_queue<Expiry, std::vector<Expiry>, std::greater<Expiry>>;
+
+template <class Record>
+class JobTable {
+public:
+    struct Running {
+        HostAlloc hosts;
+        double    start    = 0;
+        double    end      = 0;      // predicted end (start + planned runtime)
+        uint32_t  nb_hosts = 0;
+        bool      active   = false;
+    };
+
+    /* new handle for a submitted job */
+    JobHandle intern(const std::string& id)
+    {
+        uint32_t i = slots.acquire();
+        Slot& s = slots[i];
+        s.id   = id;                 // reuses the previous owner's buffer
+        s.used = true;
+        s.run.active = false;
+        s.rec  = Record();
+        index[id] = i;
+        return JobHandle{i, s.gen};
+    }
+
+    /* handle of a known job id, invalid handle otherwise */
+    JobHandle lookup(const std::string& id) const
+    {
+        auto it = index.find(id);
+        if (it == index.end()) return JobHandle{};
+        return JobHandle{it->second, slots[it->second].gen};
+    }
+
+    bool alive(JobHandle h) const
+    {
+        return h.valid() && h.idx < slots.extent() &&
+               slots[h.idx].used && slots[h.idx].gen == h.gen;
+    }
+
+    const std::string& id(JobHandle h) const { return slots[h.idx].id; }
+    Record&            record(JobHandle h)   { return slots[h.idx].rec; }
+    Running&           running(JobHandle h)  { return slots[h.idx].run; }
+
+    /* the job is gone: forget its id and recycle the slot */
+    void retire(JobHandle h)
+    {
+        if (!alive(h)) return;
+        Slot& s = slots[h.idx];
+        index.erase(s.id);
+        s.used = false;
+        s.run.active = false;
+        s.run.hosts.clear();         // keeps capacity for the next job
+        ++s.gen;
+        slots.release(h.idx);
+    }
+
+    size_t live() const { return slots.stats().live; }
+
+    /* f(handle) for every live job, in slot order */
+    template <class F>
+    void for_each(F f) const
+    {
+        for (uint32_t i = 0; i < slots.extent(); ++i)
+            if (slots[i].used) f(JobHandle{i, slots[i].gen});
+    }
+
+    const SlabStats& stats() const { return slots.stats(); }
+
+    void clear()
+    {
+        slots.clear(); index.clear();
+    }
+
+private:
+    struct Slot {
+        std::string id;
+        uint32_t    gen  = 0;
+        bool        used = false;
+        Running     run;
+        Record      rec;
+    };
+
+    SlabPool<Slot>                            slots;
+    std::unordered_map<std::string, uint32_t> index;
+};
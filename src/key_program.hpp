@@ -0,0 +1,472 @@
+/**************************************************************
+ *  key_program.hpp  —  queue-order keys given as expressions,
+ *                      compiled to a column bytecode
+ *
+ *  A key is an arithmetic expression over the fields of a job:
+ *
+ *      nb_hosts  walltime  submit_time  submit_age  now
+ *      numbers   + - * / ^  unary -  ( )
+ *      log10( )  log2( )  ln( )  sqrt( )  abs( )  exp( )
+ *
+ *  e.g. "log10(walltime)*nb_hosts+870*log10(submit_age)".  Smaller
+ *  key = served first, as in policies.hpp.  compile_keys() takes
+ *  several keys separated by ';', compared lexicographically.
+ *
+ *  Constant subexpressions are folded and a constant operand is
+ *  fused into its operator, so the program is a short list of
+ *  stack instructions.  eval() runs each instruction over a block
+ *  of BLOCK jobs before the next one: the dispatch is paid once
+ *  per block, and the arithmetic loops are plain array loops the
+ *  compiler vectorises.  A NaN key (log of a negative, 0/0, ...)
+ *  counts as +inf, so the order stays total.
+ *
+ *  In a key that moves with time, the parts that do not (e.g.
+ *  log10(walltime) above) can be hoisted out as statics: columns
+ *  the caller computes once per job and hands back to eval().
+ *
+ *      compile               O(length of the source)
+ *      eval over n jobs      O(n · instructions)
+ *************************************************************/
+#pragma once
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+class KeyProgram {
+public:
+    static constexpr size_t BLOCK = 256;
+
+    /* false, with a message in err, if src is not an expression; with
+       `hoist`, the time-independent parts of a moving key become statics */
+    bool compile(const std::string& src, std::string& err, bool hoist = false)
+    {
+        text = src; p = 0; code.clear(); statics_.clear(); timed = false; err.clear();
+        std::unique_ptr<Node> n = parse_sum(err);
+        skip_blanks();
+        if (n && p != text.size()) {
+            err = "unexpected '" + text.substr(p, 1) + "' at " + std::to_string(p);
+            n.reset();
+        }
+        if (!n) { code.clear(); return false; }
+
+        if (hoist && timed) hoist_statics(n);
+        finish(*n);
+        return true;
+    }
+
+    /* the key moves with time (submit_age or now) */
+    bool uses_now() const { return timed; }
+
+    const std::string& source() const { return text; }
+
+    /* static columns eval() expects, 0 unless hoisted */
+    size_t statics() const { return statics_.size(); }
+
+    /* st[i*stride + c] := static c of job i, i < n */
+    void eval_statics(const uint32_t* hosts, const double* wall, const double* submit,
+                      size_t n, double* st, size_t stride) const
+    {
+        for (size_t c = 0; c < statics_.size(); ++c)
+            for (size_t b = 0; b < n; b += BLOCK) {
+                const size_t m = std::min(BLOCK, n - b);
+                const double* r = statics_[c].run(hosts + b, wall + b, submit + b, m, 0.0,
+                                                  nullptr, 0);
+                for (size_t i = 0; i < m; ++i) st[(b + i)*stride + c] = r[i];
+            }
+    }
+
+    /* out[i] := key of job i at `now`, i < n; its statics at st[i*stride] */
+    void eval(const uint32_t* hosts, const double* wall, const double* submit,
+              size_t n, double now, double* out,
+              const double* st = nullptr, size_t stride = 0) const
+    {
+        for (size_t b = 0; b < n; b += BLOCK) {
+            const size_t m = std::min(BLOCK, n - b);
+            const double* r = run(hosts + b, wall + b, submit + b, m, now,
+                                  st ? st + b*stride : nullptr, stride);
+            if (m == BLOCK) keys_out(out + b, r, BLOCK);
+            else            keys_out(out + b, r, m);
+        }
+    }
+
+private:
+    enum class Var : uint8_t { NB_HOSTS, WALLTIME, SUBMIT_TIME, SUBMIT_AGE, NOW, STATIC };
+
+    enum class Op : uint8_t {
+        LOAD, CONST,                            // push a column
+        ADD, SUB, MUL, DIV, POW,                // pop two, push one
+        ADD_C, SUB_C, RSUB_C, MUL_C, DIV_C,     // top op= c (RSUB/RDIV: c op top)
+        RDIV_C, POW_C,
+        NEG, LOG10, LOG2, LN, SQRT, ABS, EXP    // on the top column
+    };
+
+    struct Ins {
+        Op       op;
+        Var      var;
+        uint32_t slot;                          // STATIC: column
+        double   c;
+    };
+
+    /* parse tree, only alive during compile() */
+    struct Node {
+        enum Kind { NUM, VAR, UN, BIN } kind;
+        double   c    = 0;
+        Var      var  = Var::NB_HOSTS;
+        uint32_t slot = 0;
+        Op       op   = Op::NEG;                // UN: NEG..EXP, BIN: ADD..POW
+        std::unique_ptr<Node> a, b;
+    };
+
+    std::string      text;
+    size_t           p = 0;                     // parse position
+    std::vector<Ins> code;
+    size_t           depth = 0;                 // stack columns needed
+    bool             timed = false;
+    std::vector<KeyProgram> statics_;           // hoisted parts
+    mutable std::vector<double> scratch;        // depth columns of BLOCK
+
+    /* the program over m <= BLOCK jobs; the result column, NaNs kept.
+       Full blocks run loops of constant length BLOCK over unaliased
+       columns, which the compiler vectorises even at -O2.             */
+    const double* run(const uint32_t* hosts, const double* wall, const double* submit,
+                      size_t m, double now, const double* st, size_t stride) const
+    {
+        return m == BLOCK ? run_n<BLOCK>(hosts, wall, submit, m, now, st, stride)
+                          : run_n<0>(hosts, wall, submit, m, now, st, stride);
+    }
+
+    template <size_t N>
+    const double* run_n(const uint32_t* hosts, const double* wall, const double* submit,
+                        size_t m, double now, const double* st, size_t stride) const
+    {
+        const size_t n = N ? N : m;
+        double* top = scratch.data();           // next free column
+        for (const Ins& in : code) {
+            double* x = top - BLOCK;            // column on top
+            const double c = in.c;
+            switch (in.op) {
+                case Op::LOAD:
+                    if (in.var == Var::STATIC)
+                        for (size_t i = 0; i < n; ++i) top[i] = st[i*stride + in.slot];
+                    else load(in.var, hosts, wall, submit, n, now, top);
+                    top += BLOCK; break;
+                case Op::CONST:
+                    for (size_t i = 0; i < n; ++i) top[i] = c;
+                    top += BLOCK; break;
+                case Op::ADD: top -= BLOCK; each2(x - BLOCK, top, n, [](double a, double b){ return a + b; }); break;
+                case Op::SUB: top -= BLOCK; each2(x - BLOCK, top, n, [](double a, double b){ return a - b; }); break;
+                case Op::MUL: top -= BLOCK; each2(x - BLOCK, top, n, [](double a, double b){ return a * b; }); break;
+                case Op::DIV: top -= BLOCK; each2(x - BLOCK, top, n, [](double a, double b){ return a / b; }); break;
+                case Op::POW: top -= BLOCK; each2(x - BLOCK, top, n, [](double a, double b){ return std::pow(a, b); }); break;
+                case Op::ADD_C:  each(x, n, [c](double a){ return a + c; }); break;
+                case Op::SUB_C:  each(x, n, [c](double a){ return a - c; }); break;
+                case Op::RSUB_C: each(x, n, [c](double a){ return c - a; }); break;
+                case Op::MUL_C:  each(x, n, [c](double a){ return a * c; }); break;
+                case Op::DIV_C:  each(x, n, [c](double a){ return a / c; }); break;
+                case Op::RDIV_C: each(x, n, [c](double a){ return c / a; }); break;
+                case Op::POW_C:  each(x, n, [c](double a){ return std::pow(a, c); }); break;
+                case Op::NEG:    each(x, n, [](double a){ return -a; }); break;
+                case Op::LOG10:  each(x, n, [](double a){ return std::log10(a); }); break;
+                case Op::LOG2:   each(x, n, [](double a){ return std::log2(a); }); break;
+                case Op::LN:     each(x, n, [](double a){ return std::log(a); }); break;
+                case Op::SQRT:   each(x, n, [](double a){ return std::sqrt(a); }); break;
+                case Op::ABS:    each(x, n, [](double a){ return std::fabs(a); }); break;
+                case Op::EXP:    each(x, n, [](double a){ return std::exp(a); }); break;
+            }
+        }
+        return top - BLOCK;
+    }
+
+    /* NaN counts as +inf */
+    static void keys_out(double* __restrict out, const double* __restrict r, size_t n)
+    {
+        for (size_t i = 0; i < n; ++i) out[i] = r[i] == r[i] ? r[i] : HUGE_VAL;
+    }
+
+    template <class F>
+    static void each(double* __restrict x, size_t n, F f)
+    {
+        for (size_t i = 0; i < n; ++i) x[i] = f(x[i]);
+    }
+
+    template <class F>
+    static void each2(double* __restrict x, const double* __restrict y, size_t n, F f)
+    {
+        for (size_t i = 0; i < n; ++i) x[i] = f(x[i], y[i]);
+    }
+
+    static void load(Var v, const uint32_t* __restrict hosts, const double* __restrict wall,
+                     const double* __restrict submit, size_t n, double now,
+                     double* __restrict col)
+    {
+        switch (v) {
+            case Var::NB_HOSTS:    for (size_t i = 0; i < n; ++i) col[i] = hosts[i]; break;
+            case Var::WALLTIME:    for (size_t i = 0; i < n; ++i) col[i] = wall[i]; break;
+            case Var::SUBMIT_TIME: for (size_t i = 0; i < n; ++i) col[i] = submit[i]; break;
+            case Var::SUBMIT_AGE:  for (size_t i = 0; i < n; ++i) col[i] = now - submit[i]; break;
+            case Var::NOW:         for (size_t i = 0; i < n; ++i) col[i] = now; break;
+            case Var::STATIC:      break;
+        }
+    }
+
+    static double apply(Op op, double x, double y = 0)
+    {
+        switch (op) {
+            case Op::ADD:   return x + y;
+            case Op::SUB:   return x - y;
+            case Op::MUL:   return x * y;
+            case Op::DIV:   return x / y;
+            case Op::POW:   return std::pow(x, y);
+            case Op::NEG:   return -x;
+            case Op::LOG10: return std::log10(x);
+            case Op::LOG2:  return std::log2(x);
+            case Op::LN:    return std::log(x);
+            case Op::SQRT:  return std::sqrt(x);
+            case Op::ABS:   return std::fabs(x);
+            case Op::EXP:   return std::exp(x);
+            default:        return x;
+        }
+    }
+
+    /* ---- parser: sum := product (('+'|'-') product)*
+                    product := unary (('*'|'/') unary)*
+                    unary := '-' unary | power
+                    power := atom ('^' unary)?                         ---- */
+    void skip_blanks()
+    {
+        while (p < text.size() && std::isspace(static_cast<unsigned char>(text[p]))) ++p;
+    }
+
+    bool eat(char c)
+    {
+        skip_blanks();
+        if (p < text.size() && text[p] == c) { ++p; return true; }
+        return false;
+    }
+
+    static std::unique_ptr<Node> make(Node::Kind k)
+    {
+        auto n = std::make_unique<Node>();
+        n->kind = k;
+        return n;
+    }
+
+    /* op(a[, b]), folded when the operands are numbers */
+    static std::unique_ptr<Node> combine(Op op, std::unique_ptr<Node> a,
+                                         std::unique_ptr<Node> b = nullptr)
+    {
+        if (a->kind == Node::NUM && (!b || b->kind == Node::NUM)) {
+            a->c = apply(op, a->c, b ? b->c : 0);
+            return a;
+        }
+        auto n = make(b ? Node::BIN : Node::UN);
+        n->op = op; n->a = std::move(a); n->b = std::move(b);
+        return n;
+    }
+
+    std::unique_ptr<Node> parse_sum(std::string& err)
+    {
+        auto n = parse_product(err);
+        while (n) {
+            Op op;
+            if      (eat('+')) op = Op::ADD;
+            else if (eat('-')) op = Op::SUB;
+            else break;
+            auto r = parse_product(err);
+            if (!r) return nullptr;
+            n = combine(op, std::move(n), std::move(r));
+        }
+        return n;
+    }
+
+    std::unique_ptr<Node> parse_product(std::string& err)
+    {
+        auto n = parse_unary(err);
+        while (n) {
+            Op op;
+            if      (eat('*')) op = Op::MUL;
+            else if (eat('/')) op = Op::DIV;
+            else break;
+            auto r = parse_unary(err);
+            if (!r) return nullptr;
+            n = combine(op, std::move(n), std::move(r));
+        }
+        return n;
+    }
+
+    std::unique_ptr<Node> parse_unary(std::string& err)
+    {
+        if (eat('-')) {
+            auto n = parse_unary(err);
+            return n ? combine(Op::NEG, std::move(n)) : nullptr;
+        }
+        if (eat('+')) return parse_unary(err);
+        auto n = parse_atom(err);
+        if (n && eat('^')) {
+            auto r = parse_unary(err);                  // right-associative
+            if (!r) return nullptr;
+            n = combine(Op::POW, std::move(n), std::move(r));
+        }
+        return n;
+    }
+
+    std::unique_ptr<Node> parse_atom(std::string& err)
+    {
+        skip_blanks();
+        if (p >= text.size()) { err = "expression ends too early"; return nullptr; }
+
+        if (eat('(')) {
+            auto n = parse_sum(err);
+            if (n && !eat(')')) { err = "missing ')' at " + std::to_string(p); return nullptr; }
+            return n;
+        }
+
+        const char* s = text.c_str() + p;
+        if (std::isdigit(static_cast<unsigned char>(*s)) || *s == '.') {
+            char* e;
+            auto n = make(Node::NUM);
+            n->c = std::strtod(s, &e);
+            p += static_cast<size_t>(e - s);
+            return n;
+        }
+
+        size_t b = p;
+        while (p < text.size() &&
+               (std::isalnum(static_cast<unsigned char>(text[p])) || text[p] == '_')) ++p;
+        std::string name = text.substr(b, p - b);
+        if (name.empty()) { err = "unexpected '" + text.substr(p, 1) + "' at " + std::to_string(p); return nullptr; }
+
+        static const struct { const char* name; Var v; } vars[] = {
+            {"nb_hosts", Var::NB_HOSTS}, {"walltime", Var::WALLTIME},
+            {"submit_time", Var::SUBMIT_TIME}, {"submit_age", Var::SUBMIT_AGE},
+            {"now", Var::NOW}
+        };
+        for (const auto& v : vars)
+            if (name == v.name) {
+                auto n = make(Node::VAR);
+                n->var = v.v;
+                timed |= (v.v == Var::SUBMIT_AGE || v.v == Var::NOW);
+                return n;
+            }
+
+        static const struct { const char* name; Op op; } funcs[] = {
+            {"log10", Op::LOG10}, {"log2", Op::LOG2}, {"ln", Op::LN},
+            {"sqrt", Op::SQRT}, {"abs", Op::ABS}, {"exp", Op::EXP}
+        };
+        for (const auto& f : funcs)
+            if (name == f.name) {
+                if (!eat('(')) { err = "'(' expected after " + name; return nullptr; }
+                auto n = parse_sum(err);
+                if (n && !eat(')')) { err = "missing ')' at " + std::to_string(p); return nullptr; }
+                return n ? combine(f.op, std::move(n)) : nullptr;
+            }
+
+        err = "unknown name '" + name + "'";
+        return nullptr;
+    }
+
+    /* ---- code generation; sp: columns on the stack ------------------- */
+    static bool moves(const Node& n)
+    {
+        switch (n.kind) {
+            case Node::NUM: return false;
+            case Node::VAR: return n.var == Var::SUBMIT_AGE || n.var == Var::NOW;
+            default:        return moves(*n.a) || (n.b && moves(*n.b));
+        }
+    }
+
+    /* every largest time-independent operation under n becomes a static */
+    void hoist_statics(std::unique_ptr<Node>& n)
+    {
+        if (n->kind != Node::UN && n->kind != Node::BIN) return;
+        if (moves(*n)) {
+            hoist_statics(n->a);
+            if (n->b) hoist_statics(n->b);
+            return;
+        }
+        statics_.emplace_back();
+        statics_.back().finish(*n);
+        auto v = make(Node::VAR);
+        v->var  = Var::STATIC;
+        v->slot = static_cast<uint32_t>(statics_.size() - 1);
+        n = std::move(v);
+    }
+
+    void finish(const Node& n)
+    {
+        size_t sp = 0;
+        depth = 0;
+        emit(n, sp);
+        scratch.assign(depth * BLOCK, 0.0);
+    }
+
+    void push_ins(Op op, double c = 0, Var v = Var::NB_HOSTS, uint32_t slot = 0)
+    {
+        code.push_back(Ins{op, v, slot, c});
+    }
+
+    void emit(const Node& n, size_t& sp)
+    {
+        switch (n.kind) {
+            case Node::NUM: push_ins(Op::CONST, n.c); depth = std::max(depth, ++sp); return;
+            case Node::VAR: push_ins(Op::LOAD, 0, n.var, n.slot); depth = std::max(depth, ++sp); return;
+            case Node::UN:  emit(*n.a, sp); push_ins(n.op); return;
+            case Node::BIN: break;
+        }
+
+        /* a constant operand rides in the instruction (a + b == b + a
+           and a * b == b * a hold exactly, so operands may swap)      */
+        const Node& a = *n.a;
+        const Node& b = *n.b;
+        if (b.kind == Node::NUM) {
+            emit(a, sp);
+            switch (n.op) {
+                case Op::ADD: push_ins(Op::ADD_C, b.c); return;
+                case Op::SUB: push_ins(Op::SUB_C, b.c); return;
+                case Op::MUL: push_ins(Op::MUL_C, b.c); return;
+                case Op::DIV: push_ins(Op::DIV_C, b.c); return;
+                default:      push_ins(Op::POW_C, b.c); return;
+            }
+        }
+        if (a.kind == Node::NUM && n.op != Op::POW) {
+            emit(b, sp);
+            switch (n.op) {
+                case Op::ADD: push_ins(Op::ADD_C, a.c); return;
+                case Op::SUB: push_ins(Op::RSUB_C, a.c); return;
+                case Op::MUL: push_ins(Op::MUL_C, a.c); return;
+                default:      push_ins(Op::RDIV_C, a.c); return;
+            }
+        }
+        emit(a, sp);
+        emit(b, sp);
+        push_ins(n.op);
+        --sp;
+    }
+};
+
+/* keys separated by ';' into `keys` (hoisting as compile() does); false,
+   with a message in err, on the first one that does not compile        */
+inline bool compile_keys(const std::string& src, std::vector<KeyProgram>& keys,
+                         std::string& err, bool hoist = false)
+{
+    keys.clear();
+    size_t b = 0;
+    for (;;) {
+        size_t e = src.find(';', b);
+        if (e == std::string::npos) e = src.size();
+        keys.emplace_back();
+        if (!keys.back().compile(src.substr(b, e - b), err, hoist)) {
+            err = "'" + src.substr(b, e - b) + "': " + err;
+            return false;
+        }
+        if (e == src.size()) return true;
+        b = e + 1;
+    }
+}
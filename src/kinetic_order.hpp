@@ -0,0 +1,428 @@
+/**************************************************************
+ *  kinetic_order.hpp  —  kinetic sorted list for keys that are
+ *                        linear functions of the current time
+ *
+ *  Each job's key is  key(t) = intercept + slope * t  (EXP is
+ *  one: -(t - submit + walltime) / walltime).  Two such keys
+ *  swap at most once, at a time computable from the lines, so
+ *  the order is kept in a balanced tree and only repaired when
+ *  a certificate between two neighbours fails:
+ *
+ *      insert / erase        O(log n)
+ *      advance(t)            O(log n) per swap due before t
+ *      front, back, walk     O(1) per job
+ *
+ *  Comparisons use Line::key(job, t) exactly, with arrival seq as
+ *  tie-breaker, so the order at t is the one a sort would give.
+ *
+ *  Line must provide static  key(job, t), intercept(job) and
+ *  slope(job); Job must expose a `uint64_t seq` member.
+ *
+ *  Nodes of erased jobs are kept and reused by later inserts, and
+ *  stale certificates are dropped in place, so once the queue has
+ *  reached its size the order no longer allocates.
+ *************************************************************/
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <queue>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+/* certificate min-heap whose stale entries can be dropped in place */
+template <class Cert>
+struct CertQueue : std::priority_queue<Cert> {
+    template <class Stale>
+    void drop_if(Stale stale)
+    {
+        auto& v = this->c;
+        v.erase(std::remove_if(v.begin(), v.end(), stale), v.end());
+        std::make_heap(v.begin(), v.end(), this->comp);
+    }
+};
+
+template <class Job, class Line>
+class KineticOrder {
+public:
+    struct Slot;
+
+private:
+    struct Cmp {
+        const double *now;
+        bool operator()(const Slot* a, const Slot* b) const
+        {
+            double ka = Line::key(a->job, *now), kb = Line::key(b->job, *now);
+            return ka < kb || (ka == kb && a->job->seq < b->job->seq);
+        }
+    };
+    using Tree = std::set<Slot*, Cmp>;
+    using Self = std::unordered_map<uint64_t, Slot*>;
+
+public:
+    /* a tree node: keeps its place, the job it holds changes on swaps */
+    struct Slot {
+        Job                     *job;
+        double                   a, b;    // intercept and slope of job's key
+        uint32_t                 ver;     // bumps invalidate queued certificates
+        typename Tree::iterator  node;
+    };
+
+    struct const_iterator {
+        typename Tree::const_iterator it;
+        const Slot& operator*()  const { return **it; }
+        const Slot* operator->() const { return *it; }
+        const_iterator& operator++()    { ++it; return *this; }
+        const_iterator  operator++(int) { const_iterator c = *this; ++it; return c; }
+        bool operator==(const const_iterator& o) const { return it == o.it; }
+        bool operator!=(const const_iterator& o) const { return it != o.it; }
+    };
+
+    KineticOrder() : tree(Cmp{&now_}) {}
+    KineticOrder(const KineticOrder&) = delete;
+    KineticOrder& operator=(const KineticOrder&) = delete;
+
+    /* repair the order so that it holds at time t (t never decreases) */
+    void advance(double t)
+    {
+        if (t > now_) now_ = t;
+        while (!certs.empty() && certs.top().t <= now_) {
+            Cert c = certs.top(); certs.pop();
+            Slot* l = c.left;
+            if (l->ver != c.ver) continue;                 // stale
+            auto nx = std::next(l->node);
+            if (nx == tree.end()) continue;
+            Slot* r = *nx;
+            if (tree.key_comp()(r, l)) {
+                swap_jobs(l, r);
+                ++swaps_;
+                if (l->node != tree.begin()) schedule(*std::prev(l->node));
+                schedule(l);
+                schedule(r);
+            } else {
+                /* crossing predicted up to now but not observed: look again later */
+                ++l->ver;
+                certs.push(Cert{std::nextafter(now_, INF), l, l->ver});
+            }
+        }
+        if (certs.size() > 4 * tree.size() + 64) compact();
+    }
+
+    /* jobs are inserted at the current time of the order */
+    void insert(Job* j) { insert(j, *this); }
+
+    /* insert j into nodes `from` (this or another order) freed, if any */
+    void insert(Job* j, KineticOrder& from)
+    {
+        Slot* s = new_slot(j);
+        KineticOrder& src = from.tree_spare.empty() ? *this : from;
+        typename Tree::iterator it;
+        if (src.tree_spare.empty()) it = tree.insert(s).first;
+        else {
+            auto n = std::move(src.tree_spare.back()); src.tree_spare.pop_back();
+            n.value() = s;
+            it = tree.insert(std::move(n)).position;
+        }
+        s->node = it;
+        if (src.self_spare.empty()) self[j->seq] = s;
+        else {
+            auto n = std::move(src.self_spare.back()); src.self_spare.pop_back();
+            n.key() = j->seq; n.mapped() = s;
+            self.insert(std::move(n));
+        }
+        if (it != tree.begin()) schedule(*std::prev(it));
+        schedule(s);
+        make_room();
+    }
+
+    void erase(Job* j)
+    {
+        auto f = self.find(j->seq);
+        if (f == self.end()) return;
+        Slot* s = f->second;
+        auto it = s->node;
+        Slot* before = (it != tree.begin()) ? *std::prev(it) : nullptr;
+        tree_spare.push_back(tree.extract(it));
+        self_spare.push_back(self.extract(f));
+        ++s->ver;
+        spare.push_back(s);
+        if (before) schedule(before);
+    }
+
+    /* erase j and insert it into `to` (same interface as JobOrder);
+       the freed nodes go along */
+    void move_to(Job* j, KineticOrder& to)
+    {
+        if (!self.count(j->seq)) return;
+        erase(j);
+        to.insert(j, *this);
+    }
+
+    Job*   front() const { return tree.empty() ? nullptr : (*tree.begin())->job; }
+    Job*   back()  const { return tree.empty() ? nullptr : (*tree.rbegin())->job; }
+    bool   empty() const { return tree.empty(); }
+    size_t size()  const { return tree.size(); }
+    double now()   const { return now_; }
+    uint64_t swaps() const { return swaps_; }
+
+    void clear()
+    {
+        tree.clear(); self.clear(); spare.clear(); slots.clear();
+        tree_spare.clear(); self_spare.clear();
+        certs = decltype(certs)();
+    }
+
+    const_iterator begin() const { return const_iterator{tree.begin()}; }
+    const_iterator end()   const { return const_iterator{tree.end()}; }
+
+private:
+    static constexpr double INF = std::numeric_limits<double>::infinity();
+
+    struct Cert {
+        double   t;
+        Slot    *left;          // certificate between left and its successor
+        uint32_t ver;
+        bool operator<(const Cert& o) const { return t > o.t; }   // min-heap
+    };
+
+    double                       now_ = -INF;
+    uint64_t                     swaps_ = 0;
+    Tree                         tree;
+    Self                         self;                            // seq → slot
+    std::deque<Slot>             slots;                           // stable addresses
+    std::vector<Slot*>           spare;
+    std::vector<typename Tree::node_type> tree_spare;             // nodes of erased jobs,
+    std::vector<typename Self::node_type> self_spare;             // reused by insert
+    CertQueue<Cert>              certs;
+
+
+    /* room in the spare lists for every node and slot held, so that
+       erase() never allocates */
+    void make_room()
+    {
+        size_t held = tree.size() + tree_spare.size();
+        if (tree_spare.capacity() < held) { tree_spare.reserve(2 * held); self_spare.reserve(2 * held); }
+        if (spare.capacity() < slots.size()) spare.reserve(2 * slots.size());
+    }
+
+    Slot* new_slot(Job* j)
+    {
+        Slot* s;
+        if (!spare.empty()) { s = spare.back(); spare.pop_back(); }
+        else                { slots.push_back(Slot{nullptr, 0, 0, 0, {}}); s = &slots.back(); }
+        s->job = j;
+        s->a   = Line::intercept(j);
+        s->b   = Line::slope(j);
+        ++s->ver;
+        return s;
+    }
+
+    /* exchange the jobs held by two neighbouring nodes: the tree shape is
+       unchanged and becomes sorted again for the current time */
+    void swap_jobs(Slot* a, Slot* b)
+    {
+        std::swap(a->job, b->job);
+        std::swap(a->a, b->a);
+        std::swap(a->b, b->b);
+        self[a->job->seq] = a;
+        self[b->job->seq] = b;
+    }
+
+    /* (re)compute the certificate between s and its successor */
+    void schedule(Slot* s)
+    {
+        ++s->ver;
+        auto it = std::next(s->node);
+        if (it == tree.end()) return;
+        const Slot* r = *it;
+        if (!(r->b < s->b)) return;                      // r never overtakes s
+        double t = (r->a - s->a) / (s->b - r->b);
+        t -= 1e-9 * (std::fabs(t) + 1.0);                // rounding of key(): wake early
+        if (!(t > now_)) t = now_;                       // due: checked by advance()
+        certs.push(Cert{t, s, s->ver});
+    }
+
+    /* drop stale certificates */
+    void compact()
+    {
+        certs.drop_if([](const Cert& c) { return c.left->ver != c.ver; });
+    }
+};
+
+/**************************************************************
+ *  KineticTournament  —  same contract, head only
+ *
+ *  When only the first job matters (primary order of EASY), a
+ *  tournament tree over the jobs keeps one certificate per match
+ *  instead of one per neighbour pair.  A failing certificate
+ *  replays its match and the matches above it, so far fewer
+ *  events fire than swaps in a full kinetic order.
+ *
+ *      insert / erase   O(log n)
+ *      advance(t)       O(log n) per winner change before t
+ *      front            O(1)
+ *************************************************************/
+template <class Job, class Line>
+class KineticTournament {
+public:
+    KineticTournament() { grow(16); }
+    KineticTournament(const KineticTournament&) = delete;
+    KineticTournament& operator=(const KineticTournament&) = delete;
+
+    void advance(double t)
+    {
+        if (t > now_) now_ = t;
+        while (!certs.empty() && certs.top().t <= now_) {
+            Cert c = certs.top(); certs.pop();
+            if (ver[c.node] != c.ver) continue;             // stale
+            ++events_;
+            replay_up(c.node);
+        }
+        if (certs.size() > 4 * cap + 64) compact();
+    }
+
+    /* jobs are inserted at the current time of the tournament */
+    void insert(Job* j) { insert(j, *this); }
+
+    /* insert j into nodes `from` (this or another tournament) freed, if any */
+    void insert(Job* j, KineticTournament& from)
+    {
+        if (spare.empty()) grow(2 * cap);
+        int32_t l = spare.back(); spare.pop_back();
+        leaves[l] = Leaf{j, Line::intercept(j), Line::slope(j)};
+        auto& src = from.self_spare.empty() ? self_spare : from.self_spare;
+        if (src.empty()) self[j->seq] = l;
+        else {
+            auto n = std::move(src.back()); src.pop_back();
+            n.key() = j->seq; n.mapped() = l;
+            self.insert(std::move(n));
+        }
+        win[cap + l] = l;
+        replay_up((cap + l) / 2);
+        ++count;
+        size_t held = self.size() + self_spare.size();       // erase() never allocates
+        if (self_spare.capacity() < held) self_spare.reserve(2 * held);
+    }
+
+    void erase(Job* j)
+    {
+        auto f = self.find(j->seq);
+        if (f == self.end()) return;
+        int32_t l = f->second;
+        self_spare.push_back(self.extract(f));
+        leaves[l].job = nullptr;
+        win[cap + l] = -1;
+        spare.push_back(l);
+        replay_up((cap + l) / 2);
+        --count;
+    }
+
+    /* erase j and insert it into `to` (same interface as JobOrder);
+       the freed node goes along */
+    void move_to(Job* j, KineticTournament& to)
+    {
+        if (!self.count(j->seq)) return;
+        erase(j);
+        to.insert(j, *this);
+    }
+
+    Job*   front()  const { return win[1] < 0 ? nullptr : leaves[win[1]].job; }
+    bool   empty()  const { return count == 0; }
+    size_t size()   const { return count; }
+    uint64_t events() const { return events_; }
+
+    void clear()
+    {
+        self.clear(); self_spare.clear(); certs = decltype(certs)(); count = 0;
+        grow(16, true);
+    }
+
+private:
+    static constexpr double INF = std::numeric_limits<double>::infinity();
+
+    struct Leaf { Job *job; double a, b; };
+    struct Cert {
+        double   t;
+        uint32_t node;
+        uint32_t ver;
+        bool operator<(const Cert& o) const { return t > o.t; }   // min-heap
+    };
+
+    double                    now_ = -INF;
+    uint64_t                  events_ = 0;
+    uint32_t                  cap = 0;       // leaves, power of two
+    size_t                    count = 0;
+    std::vector<Leaf>         leaves;
+    std::vector<int32_t>      win;           // heap-shaped, win[1] is the root
+    std::vector<uint32_t>     ver;
+    std::vector<int32_t>      spare;
+    using Self = std::unordered_map<uint64_t, int32_t>;
+    Self                      self;          // seq → leaf
+    std::vector<Self::node_type> self_spare; // nodes of erased jobs
+    CertQueue<Cert>           certs;
+
+
+    bool before(int32_t x, int32_t y) const
+    {
+        double kx = Line::key(leaves[x].job, now_), ky = Line::key(leaves[y].job, now_);
+        return kx < ky || (kx == ky && leaves[x].job->seq < leaves[y].job->seq);
+    }
+
+    /* play match i at the current time and certify its result; true when
+       the winner changed */
+    bool replay(uint32_t i)
+    {
+        int32_t x = win[2 * i], y = win[2 * i + 1];
+        int32_t w = (x < 0) ? y : (y < 0) ? x : (before(y, x) ? y : x);
+        bool changed = (w != win[i]);
+        win[i] = w;
+        ++ver[i];
+        if (x >= 0 && y >= 0) {
+            const Leaf& lw = leaves[w];
+            const Leaf& ll = leaves[w == x ? y : x];
+            if (ll.b < lw.b) {                               // loser catches up
+                double t = (ll.a - lw.a) / (lw.b - ll.b);
+                t -= 1e-9 * (std::fabs(t) + 1.0);            // rounding of key()
+                if (!(t > now_)) t = std::nextafter(now_, INF);
+                certs.push(Cert{t, i, ver[i]});
+            }
+        }
+        return changed;
+    }
+
+    /* matches above an unchanged winner are unaffected */
+    void replay_up(uint32_t i)
+    {
+        for (; i >= 1; i /= 2)
+            if (!replay(i)) break;
+    }
+
+    /* resize to n leaves (power of two) and replay every match */
+    void grow(uint32_t n, bool reset = false)
+    {
+        std::vector<Leaf> old;
+        if (!reset) old.swap(leaves);
+        cap = n;
+        leaves.assign(cap, Leaf{nullptr, 0, 0});
+        win.assign(2 * cap, -1);
+        ver.assign(cap, 0);
+        spare.clear();
+        certs = decltype(certs)();
+        for (uint32_t l = 0; l < old.size(); ++l) leaves[l] = old[l];
+        for (uint32_t l = cap; l-- > 0;) {
+            if (leaves[l].job) { win[cap + l] = l; self[leaves[l].job->seq] = l; }
+            else               spare.push_back(l);
+        }
+        for (uint32_t i = cap - 1; i >= 1; --i) replay(i);
+    }
+
+    void compact()
+    {
+        certs.drop_if([this](const Cert& c) { return ver[c.node] != c.ver; });
+    }
+};
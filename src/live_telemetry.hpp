@@ -0,0 +1,223 @@
+/**************************************************************
+ *  live_telemetry.hpp  —  one sample per decision call in a
+ *                         POSIX shared-memory ring, for a
+ *                         reader to tail while Batsim runs
+ *
+ *  The plug-in is the only writer.  Each slot is a seqlock: the
+ *  writer marks it busy, stores the words, marks it done with
+ *  the sample's number, then advances `head`; it never waits,
+ *  allocates or calls into the kernel after opening.  A reader
+ *  keeps its own position, copies a slot and keeps the copy
+ *  only if the slot held the expected sample before and after.
+ *  A reader more than CAPACITY samples behind, or one whose
+ *  slot was overwritten while it was read, loses those samples
+ *  (they are counted) and goes on from the oldest one left.
+ *
+ *  The writer creates the segment and unlinks it when it closes;
+ *  a reader still attached sees `closed` and drains what is left.
+ *  A segment of the same name that already exists is never taken
+ *  over: it may be another running simulation's.
+ *************************************************************/
+#pragma once
+
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* what one decision call publishes */
+struct LiveSample {
+    double   now;              // simulated time of the call (s)
+    uint64_t call;             // decision calls so far, this one included
+    uint64_t started;          // jobs started so far
+    uint64_t backfilled;       // of which ahead of the primary order's head
+    uint64_t latency_ns;       // wall time of the call
+    uint32_t pending;          // jobs waiting after the call
+    uint32_t free_hosts;       // hosts idle after the call
+};
+
+/* the segment, as both sides map it */
+namespace live {
+
+constexpr uint64_t MAGIC    = 0x3176696c2d797365ull;   // "esy-liv1"
+constexpr uint32_t VERSION  = 1;
+constexpr uint32_t CAPACITY = uint32_t(1) << 16;         // samples, 4 MiB
+constexpr size_t   WORDS    = sizeof(LiveSample) / sizeof(uint64_t);
+
+static_assert(sizeof(LiveSample) % sizeof(uint64_t) == 0, "LiveSample is stored by words");
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "the ring needs lock-free atomics");
+
+struct alignas(64) Slot {
+    std::atomic<uint64_t> seq;             // 2n+1 while sample n is written, 2n+2 once done
+    std::atomic<uint64_t> words[WORDS];
+};
+
+struct alignas(64) Header {
+    std::atomic<uint64_t> magic;           // stored last: the rest is set
+    uint32_t              version;
+    uint32_t              capacity;
+    uint32_t              sample_size;
+    std::atomic<uint32_t> nb_hosts;        // of the platform, once known
+    int64_t               pid;
+    std::atomic<uint64_t> head;            // samples published
+    std::atomic<uint32_t> closed;          // set by the writer at the end
+};
+
+constexpr size_t BYTES = sizeof(Header) + CAPACITY * sizeof(Slot);
+
+inline Slot* slots(Header* h)
+{
+    return reinterpret_cast<Slot*>(reinterpret_cast<char*>(h) + sizeof(Header));
+}
+
+} // namespace live
+
+class LiveWriter {
+public:
+    /* creates the segment `name` ("/easy-live"); fails if it exists */
+    explicit LiveWriter(const std::string& name) : name(name)
+    {
+        int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+        if (fd < 0) {
+            why = errno == EEXIST
+                ? "already exists; another simulation writes it, or a crashed one left "
+                  "/dev/shm" + name + " behind"
+                : std::strerror(errno);
+            return;
+        }
+        void* p = MAP_FAILED;
+        if (ftruncate(fd, live::BYTES) == 0)
+            p = mmap(nullptr, live::BYTES, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (p == MAP_FAILED) why = std::strerror(errno);
+        close(fd);
+        if (p == MAP_FAILED) { shm_unlink(name.c_str()); return; }
+
+        /* ftruncate zeroed the pages: every slot reads as never written */
+        hdr = static_cast<live::Header*>(p);
+        slot = live::slots(hdr);
+        hdr->version     = live::VERSION;
+        hdr->capacity    = live::CAPACITY;
+        hdr->sample_size = sizeof(LiveSample);
+        hdr->pid         = getpid();
+        hdr->magic.store(live::MAGIC, std::memory_order_release);
+    }
+
+    ~LiveWriter()
+    {
+        if (!hdr) return;
+        hdr->closed.store(1, std::memory_order_release);
+        shm_unlink(name.c_str());
+        munmap(hdr, live::BYTES);
+    }
+
+    LiveWriter(const LiveWriter&) = delete;
+    LiveWriter& operator=(const LiveWriter&) = delete;
+
+    bool               ok()        const { return hdr != nullptr; }
+    const std::string& reason()    const { return why; }
+    uint64_t           published() const { return next; }
+
+    void set_nb_hosts(uint32_t n) { hdr->nb_hosts.store(n, std::memory_order_relaxed); }
+
+    /* overwrites the oldest sample once the ring is full */
+    void publish(const LiveSample& s)
+    {
+        uint64_t n = next++;
+        live::Slot& sl = slot[n & (live::CAPACITY - 1)];
+        uint64_t w[live::WORDS];
+        std::memcpy(w, &s, sizeof s);
+        sl.seq.store(2 * n + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t k = 0; k < live::WORDS; ++k) sl.words[k].store(w[k], std::memory_order_relaxed);
+        sl.seq.store(2 * n + 2, std::memory_order_release);
+        hdr->head.store(n + 1, std::memory_order_release);
+    }
+
+private:
+    std::string   name, why;
+    live::Header* hdr  = nullptr;
+    live::Slot*   slot = nullptr;
+    uint64_t      next = 0;
+};
+
+class LiveReader {
+public:
+    /* attaches to the segment `name`, from its oldest sample */
+    explicit LiveReader(const std::string& name)
+    {
+        int fd = shm_open(name.c_str(), O_RDONLY, 0);
+        if (fd < 0) { why = std::strerror(errno); return; }
+        struct stat st;
+        void* p = MAP_FAILED;
+        if (fstat(fd, &st) != 0 || size_t(st.st_size) < live::BYTES)
+            why = "not a telemetry segment";
+        else if ((p = mmap(nullptr, live::BYTES, PROT_READ, MAP_SHARED, fd, 0)) == MAP_FAILED)
+            why = std::strerror(errno);
+        close(fd);
+        if (p == MAP_FAILED) return;
+
+        auto* h = static_cast<live::Header*>(p);
+        if (h->magic.load(std::memory_order_acquire) != live::MAGIC || h->version != live::VERSION ||
+            h->capacity != live::CAPACITY || h->sample_size != sizeof(LiveSample)) {
+            why = "not a telemetry segment of this version";
+            munmap(p, live::BYTES);
+            return;
+        }
+        hdr  = h;
+        slot = live::slots(hdr);
+        uint64_t head = hdr->head.load(std::memory_order_acquire);
+        pos = head > live::CAPACITY ? head - live::CAPACITY : 0;
+    }
+
+    ~LiveReader() { if (hdr) munmap(hdr, live::BYTES); }
+
+    LiveReader(const LiveReader&) = delete;
+    LiveReader& operator=(const LiveReader&) = delete;
+
+    bool               ok()       const { return hdr != nullptr; }
+    const std::string& reason()   const { return why; }
+    uint32_t           nb_hosts() const { return hdr->nb_hosts.load(std::memory_order_relaxed); }
+    int64_t            pid()      const { return hdr->pid; }
+
+    /* samples skipped because the writer lapped the reader */
+    uint64_t lost() const { return lost_; }
+
+    /* hands every new sample to f(const LiveSample&); false once the
+       writer has closed and everything it published was read         */
+    template <class F> bool poll(F f)
+    {
+        bool closed = hdr->closed.load(std::memory_order_acquire);
+        uint64_t head = hdr->head.load(std::memory_order_acquire);
+        if (head - pos > live::CAPACITY) {
+            lost_ += head - live::CAPACITY - pos;
+            pos = head - live::CAPACITY;
+        }
+        for (; pos < head; ++pos) {
+            const live::Slot& sl = slot[pos & (live::CAPACITY - 1)];
+            uint64_t a = sl.seq.load(std::memory_order_acquire);
+            uint64_t w[live::WORDS];
+            for (size_t k = 0; k < live::WORDS; ++k) w[k] = sl.words[k].load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            uint64_t b = sl.seq.load(std::memory_order_relaxed);
+            if (a != 2 * pos + 2 || b != a) { ++lost_; continue; }   // overwritten meanwhile
+            LiveSample s;
+            std::memcpy(&s, w, sizeof s);
+            f(s);
+        }
+        return !closed;
+    }
+
+private:
+    std::string   why;
+    live::Header* hdr  = nullptr;
+    live::Slot*   slot = nullptr;
+    uint64_t      pos  = 0;          // next sample to read
+    uint64_t      lost_ = 0;
+};
@@ -0,0 +1,94 @@
+/**************************************************************
+ *  los_knapsack.hpp  —  lookahead (LOS) choice of the jobs to
+ *                       backfill at once
+ *
+ *  Shmueli & Feitelson's LOS: among the candidates that each fit,
+ *  take the subset using the most hosts now, instead of the first
+ *  ones of the backfill order.  Candidates running past the shadow
+ *  time must also fit together in the extra hosts, so the table
+ *  is indexed by (candidate, free hosts left, extra hosts left):
+ *
+ *      best[i][f][e] = most hosts items i.. can use in (f, e)
+ *
+ *  Ties go to the subset taking the earliest candidates, so with
+ *  room for all of them the result is the greedy one.
+ *
+ *  With a unit u > 1 the table counts hosts in blocks of u: a job
+ *  takes ceil(hosts/u) of them out of floor(free/u), so what the
+ *  table picks always fits, but it may miss a tighter subset.  The
+ *  value is still in hosts.
+ *
+ *      select(items, free, extra, u)   O(n · (free/u+1) · (extra/u+1))
+ *
+ *  cells() lets the caller bound n and u before building the table.
+ *************************************************************/
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class LosKnapsack {
+public:
+    struct Item {
+        uint32_t hosts;
+        bool     past;          // still running at the shadow time
+    };
+
+    /* table cells a selection over n items would fill */
+    static size_t cells(size_t n, uint32_t free, uint32_t extra, uint32_t unit = 1)
+    {
+        return (n + 1) * (size_t(free / unit) + 1) * (size_t(std::min(extra, free) / unit) + 1);
+    }
+
+    /* indices of the chosen items, in increasing order */
+    const std::vector<uint32_t>& select(const std::vector<Item>& items,
+                                        uint32_t free, uint32_t extra, uint32_t unit = 1)
+    {
+        extra = std::min(extra, free) / unit; // past jobs use free hosts too
+        free /= unit;
+        const size_t n  = items.size();
+        const size_t F  = size_t(free) + 1, E = size_t(extra) + 1;
+        const size_t FE = F * E;
+        best.assign((n + 1) * FE, 0);
+
+        weight.resize(n);
+        for (size_t i = 0; i < n; ++i) weight[i] = (items[i].hosts + unit - 1) / unit;
+
+        for (size_t i = n; i-- > 0; ) {
+            const uint32_t q    = weight[i];
+            const uint32_t h    = items[i].hosts;
+            const uint32_t* nx  = &best[(i + 1) * FE];
+            uint32_t*       cur = &best[i * FE];
+            for (size_t f = 0; f < F; ++f) {
+                for (size_t e = 0; e < E; ++e) {
+                    uint32_t v = nx[f * E + e];
+                    if (q <= f && (!items[i].past || q <= e)) {
+                        size_t e2 = items[i].past ? e - q : e;
+                        v = std::max(v, nx[(f - q) * E + e2] + h);
+                    }
+                    cur[f * E + e] = v;
+                }
+            }
+        }
+
+        chosen.clear();
+        size_t f = free, e = extra;
+        for (size_t i = 0; i < n; ++i) {
+            const uint32_t q = weight[i];
+            if (q > f || (items[i].past && q > e)) continue;
+            size_t e2 = items[i].past ? e - q : e;
+            if (best[(i + 1) * FE + (f - q) * E + e2] + items[i].hosts != best[i * FE + f * E + e])
+                continue;
+            chosen.push_back(static_cast<uint32_t>(i));
+            f -= q; e = e2;
+        }
+        return chosen;
+    }
+
+private:
+    std::vector<uint32_t> best;               // reused between calls
+    std::vector<uint32_t> weight;             // blocks of each item
+    std::vector<uint32_t> chosen;
+};
@@ -0,0 +1,142 @@
+/**************************************************************
+ *  order_adapter.hpp  —  queue orders picked by what-if replays
+ *                        (#adapt, what_if.hpp)
+ *
+ *  At most once per PERIOD, at a decision call, the running and
+ *  pending jobs are snapshot with predicted runtimes and replayed
+ *  for HORIZON under every candidate pair; the caller rebuilds
+ *  its engine for the best one when it beats the current pair by
+ *  MARGIN, and the pending jobs are handed over in arrival order.
+ *  An evaluation costs at most BUDGET work units, split over the
+ *  candidates; a replay over its share gives no score.
+ *************************************************************/
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "policies.hpp"
+#include "what_if.hpp"
+
+/* primary and backfill orders */
+struct OrderPair { Policy p, b; };
+
+inline const char* policy_name(Policy p)
+{
+    for (const auto& [name, pol] : STR2POL) if (pol == p) return name.c_str();
+    return "?";
+}
+
+/* "P" or "P,B" items separated by '/', appended; false on an unknown name */
+inline bool parse_pairs(const std::string& list, std::vector<OrderPair>& out)
+{
+    size_t b = 0;
+    while (b <= list.size()) {
+        size_t e = list.find('/', b);
+        if (e == std::string::npos) e = list.size();
+        std::string item = list.substr(b, e-b);
+        size_t comma = item.find(',');
+        auto p = STR2POL.find(item.substr(0, comma));
+        auto q = STR2POL.find(comma == std::string::npos ? item : item.substr(comma+1));
+        if (p == STR2POL.end() || q == STR2POL.end()) return false;
+        out.push_back(OrderPair{p->second, q->second});
+        b = e+1;
+    }
+    return true;
+}
+
+class OrderAdapter {
+public:
+    static constexpr double   PERIOD  = 3600.0;
+    static constexpr double   HORIZON = 4 * 3600.0;
+    static constexpr double   MARGIN  = 0.02;
+    static constexpr uint64_t BUDGET  = uint64_t(1) << 24;   // work units per evaluation
+
+    /* candidates: `given` (the current pair), then those of `list`
+       ("*" ⇒ fcfs/spf/exp), each once; off unless two remain.
+       false if the list has an unknown name.                      */
+    bool set_pairs(OrderPair given, const std::string& list)
+    {
+        pairs.assign(1, given);
+        bool ok = parse_pairs(list == "*" ? "fcfs/spf/exp" : list, pairs);
+        auto same = [](const OrderPair& a, const OrderPair& b){ return a.p == b.p && a.b == b.b; };
+        for (size_t i = 1; i < pairs.size(); )
+            if (std::any_of(pairs.begin(), pairs.begin()+i,
+                            [&](const OrderPair& o){ return same(o, pairs[i]); }))
+                pairs.erase(pairs.begin()+i);
+            else ++i;
+        if (pairs.size() < 2) pairs.clear();
+        return ok;
+    }
+
+    bool on() const { return !pairs.empty(); }
+    bool due(double now) const { return now >= next; }
+
+    /* replays the snapshot take_snapshot() gives under every candidate,
+       with prm's threshold, extra nodes and metric; the pair to switch
+       to, or nullptr to keep the current one                           */
+    template <class Snapshot>
+    const OrderPair* evaluate(double now, size_t pending, WhatIfParams prm, Snapshot take_snapshot)
+    {
+        next = now + PERIOD;
+        if (pending < 2) return nullptr;
+        ++nb_evals;
+
+        WhatIfReplay replay(take_snapshot());
+        prm.horizon = HORIZON;
+        prm.budget  = BUDGET / pairs.size();
+
+        double cur = replay.run(pairs[current].p, pairs[current].b, prm);
+        if (std::isnan(cur)) { ++nb_over_budget; return nullptr; }
+        size_t best = current;
+        double best_score = cur;
+        for (size_t c = 0; c < pairs.size(); ++c) {
+            if (c == current) continue;
+            double sc = replay.run(pairs[c].p, pairs[c].b, prm);
+            if (std::isnan(sc)) { ++nb_over_budget; continue; }
+            if (sc < best_score) { best = c; best_score = sc; }
+        }
+        if (best == current || best_score >= cur * (1.0 - MARGIN)) return nullptr;
+        current = best;
+        ++nb_switches;
+        return &pairs[best];
+    }
+
+    /* the pending jobs of `jobs`, in arrival order (records expose seq),
+       for the engine built for the new pair                             */
+    template <class Table, class Job>
+    static void waiting(Table& jobs, std::vector<Job*>& out)
+    {
+        out.clear();
+        jobs.for_each([&](auto h){
+            if (!jobs.running(h).active) out.push_back(&jobs.record(h));
+        });
+        std::sort(out.begin(), out.end(), [](const Job* a, const Job* b){ return a->seq < b->seq; });
+    }
+
+    void report(const char* who) const
+    {
+        std::printf("%s: adapt evaluations=%llu switches=%llu over-budget=%llu final=%s,%s\n", who,
+                    (unsigned long long)nb_evals, (unsigned long long)nb_switches,
+                    (unsigned long long)nb_over_budget,
+                    policy_name(pairs[current].p), policy_name(pairs[current].b));
+    }
+
+    void clear()
+    {
+        pairs.clear();
+        current = 0; next = 0;
+        nb_evals = nb_switches = nb_over_budget = 0;
+    }
+
+private:
+    std::vector<OrderPair> pairs;       // empty ⇒ off; [0] the pair given at init
+    size_t   current = 0;
+    double   next    = 0;               // next evaluation
+    uint64_t nb_evals = 0, nb_switches = 0, nb_over_budget = 0;
+};
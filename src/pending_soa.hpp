@@ -0,0 +1,157 @@
+/**************************************************************
+ *  pending_soa.hpp  —  pending jobs as parallel arrays, with a
+ *                      vectorised fit search
+ *
+ *  The hot numeric fields of every pending job (nb_hosts,
+ *  walltime, submit_time) are kept in contiguous arrays, which
+ *  the fit search and the key programs read;
+ *  ids and run state stay in the job table as cold data.  Removal
+ *  swaps the last job into the hole, so a job's slot is stored in
+ *  the job itself (`pos`).
+ *
+ *      insert / erase   O(1)
+ *      find_fit         O(n), 4 jobs per SSE2 or AVX2 step
+ *
+ *  AVX2 is chosen at run time when the CPU has it, SSE2 is the
+ *  x86-64 baseline, other targets use the scalar loop.  All three
+ *  make the same IEEE comparisons, so they find the same job.
+ *
+ *  There is no key column.  Built-in orders live in persistent
+ *  indexes (job_order.hpp, kinetic_order.hpp for EXP) that a pass
+ *  walks without evaluating any key, and expression keys are run
+ *  by key_program.hpp over these arrays into rows the engine keeps
+ *  beside them.  A column here would be one more copy to keep in
+ *  step, read by nothing.
+ *
+ *  Job must expose `nb_hosts`, `walltime`, `submit_time` and a
+ *  `uint32_t pos` member.  nb_hosts must stay below 2^31.
+ *************************************************************/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+# include <immintrin.h>
+# define PENDING_SOA_X86 1
+#endif
+
+namespace soa_kernels {
+
+/* first i >= from with hosts[i] <= free && now + wall[i] <= limit, or n */
+inline size_t find_fit_scalar(const uint32_t* hosts, const double* wall, size_t n,
+                              size_t from, uint32_t free, double now, double limit)
+{
+    for (size_t i = from; i < n; ++i)
+        if (hosts[i] <= free && now + wall[i] <= limit) return i;
+    return n;
+}
+
+#ifdef PENDING_SOA_X86
+inline size_t find_fit_sse2(const uint32_t* hosts, const double* wall, size_t n,
+                            uint32_t free, double now, double limit)
+{
+    const __m128i fv = _mm_set1_epi32(static_cast<int32_t>(free));
+    const __m128d nv = _mm_set1_pd(now), lv = _mm_set1_pd(limit);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i wide = _mm_cmpgt_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(hosts + i)), fv);
+        __m128d w01  = _mm_cmple_pd(_mm_add_pd(nv, _mm_loadu_pd(wall + i)),     lv);
+        __m128d w23  = _mm_cmple_pd(_mm_add_pd(nv, _mm_loadu_pd(wall + i + 2)), lv);
+        __m128d f01  = _mm_andnot_pd(_mm_castsi128_pd(_mm_unpacklo_epi32(wide, wide)), w01);
+        __m128d f23  = _mm_andnot_pd(_mm_castsi128_pd(_mm_unpackhi_epi32(wide, wide)), w23);
+        int m = _mm_movemask_pd(f01) | (_mm_movemask_pd(f23) << 2);
+        if (m) return i + static_cast<size_t>(__builtin_ctz(static_cast<unsigned>(m)));
+    }
+    return find_fit_scalar(hosts, wall, n, i, free, now, limit);
+}
+
+__attribute__((target("avx2")))
+inline size_t find_fit_avx2(const uint32_t* hosts, const double* wall, size_t n,
+                            uint32_t free, double now, double limit)
+{
+    const __m128i fv = _mm_set1_epi32(static_cast<int32_t>(free));
+    const __m256d nv = _mm256_set1_pd(now), lv = _mm256_set1_pd(limit);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i wide = _mm_cmpgt_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(hosts + i)), fv);
+        __m256d ok   = _mm256_cmp_pd(_mm256_add_pd(nv, _mm256_loadu_pd(wall + i)), lv, _CMP_LE_OQ);
+        __m256d fit  = _mm256_andnot_pd(_mm256_castsi256_pd(_mm256_cvtepi32_epi64(wide)), ok);
+        int m = _mm256_movemask_pd(fit);
+        if (m) return i + static_cast<size_t>(__builtin_ctz(static_cast<unsigned>(m)));
+    }
+    return find_fit_scalar(hosts, wall, n, i, free, now, limit);
+}
+
+inline bool has_avx2()
+{
+    static const bool yes = __builtin_cpu_supports("avx2");
+    return yes;
+}
+#endif
+
+inline size_t find_fit(const uint32_t* hosts, const double* wall, size_t n,
+                       uint32_t free, double now, double limit)
+{
+#ifdef PENDING_SOA_X86
+    if (has_avx2()) return find_fit_avx2(hosts, wall, n, free, now, limit);
+    return find_fit_sse2(hosts, wall, n, free, now, limit);
+#else
+    return find_fit_scalar(hosts, wall, n, 0, free, now, limit);
+#endif
+}
+
+} // namespace soa_kernels
+
+template <class Job>
+class PendingSoA {
+public:
+    void insert(Job* j)
+    {
+        j->pos = static_cast<uint32_t>(job_.size());
+        hosts_.push_back(j->nb_hosts);
+        wall_.push_back(j->walltime);
+        submit_.push_back(j->submit_time);
+        job_.push_back(j);
+    }
+
+    void erase(Job* j)
+    {
+        uint32_t i = j->pos, last = static_cast<uint32_t>(job_.size() - 1);
+        if (i != last) {
+            hosts_[i] = hosts_[last]; wall_[i] = wall_[last];
+            submit_[i] = submit_[last];
+            job_[i] = job_[last]; job_[i]->pos = i;
+        }
+        hosts_.pop_back(); wall_.pop_back(); submit_.pop_back(); job_.pop_back();
+    }
+
+    size_t size()  const { return job_.size(); }
+    bool   empty() const { return job_.empty(); }
+
+    /* the arrays themselves, entry i for the job at pos i */
+    const uint32_t* hosts()        const { return hosts_.data(); }
+    const double*   walltimes()    const { return wall_.data(); }
+    const double*   submit_times() const { return submit_.data(); }
+    Job*            job(size_t i)  const { return job_[i]; }
+
+    /* a job with nb_hosts <= free and now + walltime <= limit, or nullptr */
+    Job* find_fit(uint32_t free, double now, double limit) const
+    {
+        size_t i = soa_kernels::find_fit(hosts_.data(), wall_.data(), job_.size(),
+                                         free, now, limit);
+        return i < job_.size() ? job_[i] : nullptr;
+    }
+
+    void clear()
+    {
+        hosts_.clear(); wall_.clear(); submit_.clear(); job_.clear();
+    }
+
+private:
+    std::vector<uint32_t> hosts_;
+    std::vector<double>   wall_;
+    std::vector<double>   submit_;
+    std::vector<Job*>     job_;
+};
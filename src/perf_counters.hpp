@@ -0,0 +1,155 @@
+/**************************************************************
+ *  perf_counters.hpp  —  hardware counters of the calling
+ *                        thread, read as one group
+ *
+ *  Cycles, instructions, last-level-cache misses and branch
+ *  misses, counted in user space for this thread by Linux
+ *  perf_event_open(2) and read together by one read(2) on the
+ *  group (~0.3 µs).  They are scheduled as a group, so the four
+ *  values of a read always cover the same instructions.
+ *
+ *  When the PMU is shared (other perf users, the NMI watchdog)
+ *  the kernel multiplexes it and the group counts only part of
+ *  the time.  Each read carries the time the group was enabled
+ *  and the time it ran; between two reads, scale() turns the raw
+ *  differences into estimates of the whole interval.
+ *
+ *  Where they cannot be opened (no PMU in a container or VM,
+ *  perf_event_paranoid, not Linux) available() is false and the
+ *  reason is kept; a counter the CPU lacks (LLC misses in many
+ *  VMs) is left out alone, and reads as 0.
+ *************************************************************/
+#pragma once
+
+#include <array>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#ifdef __linux__
+# include <linux/perf_event.h>
+# include <sys/ioctl.h>
+# include <sys/syscall.h>
+# include <unistd.h>
+#endif
+
+enum class HwCounter : uint8_t { CYCLES, INSTRUCTIONS, LLC_MISSES, BRANCH_MISSES, COUNT };
+
+inline const char* hw_counter_name(HwCounter c)
+{
+    static const char* names[] = {"cycles", "instructions", "llc_misses", "branch_misses"};
+    return names[static_cast<size_t>(c)];
+}
+
+using HwValues = std::array<uint64_t, size_t(HwCounter::COUNT)>;
+
+/* running totals, with the time (ns) the group was enabled and running */
+struct HwReading {
+    HwValues v{};
+    uint64_t enabled = 0, running = 0;
+
+    /* b - a scaled by enabled / running over the interval; 0 for all if
+       the group never ran in it.  `multiplexed` is set if it ran only
+       part of the interval.                                            */
+    static std::array<double, size_t(HwCounter::COUNT)>
+    scale(const HwReading& a, const HwReading& b, bool& multiplexed)
+    {
+        std::array<double, size_t(HwCounter::COUNT)> d{};
+        uint64_t en = b.enabled - a.enabled, run = b.running - a.running;
+        multiplexed = run < en;
+        if (run == 0) return d;
+        double f = run < en ? double(en) / double(run) : 1.0;
+        for (size_t c = 0; c < d.size(); ++c) d[c] = double(b.v[c] - a.v[c]) * f;
+        return d;
+    }
+};
+
+class PerfCounters {
+public:
+    PerfCounters()
+    {
+#ifdef __linux__
+        static const uint64_t config[] = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+                                          PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+        for (size_t i = 0; i < size_t(HwCounter::COUNT); ++i) {
+            perf_event_attr a;
+            std::memset(&a, 0, sizeof a);
+            a.size           = sizeof a;
+            a.type           = PERF_TYPE_HARDWARE;
+            a.config         = config[i];
+            a.disabled       = leader < 0;         // the group starts at once, below
+            a.exclude_kernel = 1;
+            a.exclude_hv     = 1;
+            a.read_format    = PERF_FORMAT_GROUP | PERF_FORMAT_ID |
+                               PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+            int fd = static_cast<int>(syscall(SYS_perf_event_open, &a, 0, -1, leader, 0));
+            if (fd < 0) {
+                if (leader < 0) { why = std::strerror(errno); return; }   // no group at all
+                continue;
+            }
+            uint64_t id = 0;
+            ioctl(fd, PERF_EVENT_IOC_ID, &id);
+            if (leader < 0) leader = fd;
+            fds[n] = fd; ids[n] = id; slot[n] = i; ++n;
+        }
+        ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+#else
+        why = "not Linux";
+#endif
+    }
+
+    ~PerfCounters()
+    {
+#ifdef __linux__
+        for (size_t i = 0; i < n; ++i) close(fds[i]);
+#endif
+    }
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    bool available() const { return leader >= 0; }
+
+    /* why available() is false */
+    const std::string& reason() const { return why; }
+
+    /* whether counter c was opened */
+    bool has(HwCounter c) const
+    {
+        for (size_t i = 0; i < n; ++i) if (slot[i] == size_t(c)) return true;
+        return false;
+    }
+
+    /* running totals since construction; false (r untouched) on failure */
+    bool read(HwReading& r) const
+    {
+#ifdef __linux__
+        if (leader < 0) return false;
+        struct {
+            uint64_t nr, enabled, running;
+            struct { uint64_t value, id; } e[size_t(HwCounter::COUNT)];
+        } buf;
+        if (::read(leader, &buf, sizeof buf) <= 0) return false;
+        r.v.fill(0);
+        for (uint64_t k = 0; k < buf.nr && k < n; ++k)
+            for (size_t i = 0; i < n; ++i)
+                if (ids[i] == buf.e[k].id) { r.v[slot[i]] = buf.e[k].value; break; }
+        r.enabled = buf.enabled;
+        r.running = buf.running;
+        return true;
+#else
+        (void)r;
+        return false;
+#endif
+    }
+
+private:
+    int         leader = -1;
+    size_t      n = 0;                                  // counters opened
+    int         fds[size_t(HwCounter::COUNT)]  = {};
+    uint64_t    ids[size_t(HwCounter::COUNT)]  = {};
+    size_t      slot[size_t(HwCounter::COUNT)] = {};    // HwCounter of fds[i]
+    std::string why;
+};
@@ -0,0 +1,339 @@
+/**************************************************************
+ *  phase_profile.hpp  —  latency histograms of the phases of a
+ *                        decision call, split by queue depth
+ *
+ *  A PhaseTimer reads steady_clock (a vDSO call, ~20 ns) when it
+ *  is built and destroyed, and adds the difference to its
+ *  phase's histogram; with no profile it does nothing but test a
+ *  pointer.  Histograms are log-linear (HDR-style): 16 linear
+ *  sub-buckets per power of two, so any quantile is within 6.25 %
+ *  of the truth from 1 ns to hours, in a fixed array.
+ *
+ *  Each sample is also counted under the class of the queue
+ *  depth set for the call (0, 1, 2-3, 4-7, ...), so a phase that
+ *  grows with the queue shows it.  write() leaves PREFIX.json and
+ *  PREFIX.csv with count, mean, p50, p99 and max per phase, over
+ *  all depths and per depth class.
+ *
+ *  Given a TraceWriter, every sample is also a span of the trace
+ *  (the call's carrying the simulated time), and count() adds a
+ *  point to one of the Counter series.  Given PerfCounters, each
+ *  sample also sums the hardware events between its two
+ *  readings, and the report gives their means per sample and
+ *  the IPC; the reads cost ~0.3 µs each, inside the enclosing
+ *  phases.  Samples during which the kernel multiplexed the
+ *  counters are scaled up to the whole sample and counted as
+ *  `multiplexed`; those during which they never ran add no
+ *  events and are counted as `unmeasured`, and left out of the
+ *  means.
+ *************************************************************/
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "perf_counters.hpp"
+#include "trace_writer.hpp"
+
+enum class Phase : uint8_t {
+    CALL,           // the whole batsim_edc_take_decisions()
+    DESERIALIZE,
+    EVENTS,         // submissions and completions, queue insertions included
+    CONTROL,        // prediction repairs, #spec kills, #tune, #adapt
+    DECIDE,         // the engine's decide(), the four below included
+    ORDER,          // aging promotions, time-dependent primary keys
+    RESERVATION,    // the head's shadow time, or compressing the plan
+    BACKFILL,
+    SERIALIZE,
+    COUNT
+};
+
+inline const char* phase_name(Phase p)
+{
+    static const char* names[] = {"call", "deserialize", "events", "control", "decide",
+                                  "order", "reservation", "backfill", "serialize"};
+    return names[static_cast<size_t>(p)];
+}
+
+/* series of the trace, named after the phases in its name table */
+enum class Counter : uint16_t {
+    PENDING = static_cast<uint16_t>(Phase::COUNT),
+    FREE_HOSTS,
+    RESERVE_T       // shadow time of the head (simulated seconds)
+};
+
+/* phases, then counters, as TraceWriter indexes them */
+inline std::vector<const char*> trace_names()
+{
+    std::vector<const char*> v;
+    for (size_t i = 0; i < size_t(Phase::COUNT); ++i) v.push_back(phase_name(static_cast<Phase>(i)));
+    for (const char* c : {"pending", "free_hosts", "reserve_t"}) v.push_back(c);
+    return v;
+}
+
+class LogLinearHistogram {
+public:
+    static constexpr uint32_t SUB_BITS = 4;
+    static constexpr uint64_t SUB      = uint64_t(1) << SUB_BITS;
+    static constexpr size_t   BUCKETS  = (64 - SUB_BITS + 1) * SUB;
+
+    void add(uint64_t v)
+    {
+        ++counts[index(v)];
+        ++n;
+        sum += v;
+        if (v > hi) hi = v;
+    }
+
+    uint64_t count() const { return n; }
+    uint64_t max()   const { return hi; }
+    double   mean()  const { return n ? double(sum) / n : 0.0; }
+
+    /* smallest bucket value with at least q of the samples at or below it */
+    uint64_t quantile(double q) const
+    {
+        if (!n) return 0;
+        uint64_t rank = static_cast<uint64_t>(q * (n - 1)) + 1, acc = 0;
+        for (size_t i = 0; i < BUCKETS; ++i) {
+            acc += counts[i];
+            if (acc >= rank) return std::min(upper(i), hi);
+        }
+        return hi;
+    }
+
+private:
+    uint64_t counts[BUCKETS] = {};
+    uint64_t n = 0, sum = 0, hi = 0;
+
+    static size_t index(uint64_t v)
+    {
+        if (v < SUB) return static_cast<size_t>(v);
+        uint32_t e = 63 - static_cast<uint32_t>(__builtin_clzll(v));   // >= SUB_BITS
+        uint32_t shift = e - SUB_BITS;
+        return (shift + 1) * SUB + ((v >> shift) & (SUB - 1));
+    }
+
+    /* largest value of bucket i */
+    static uint64_t upper(size_t i)
+    {
+        if (i < SUB) return i;
+        uint32_t shift = static_cast<uint32_t>(i / SUB) - 1;
+        uint64_t base  = (SUB | (i % SUB)) << shift;
+        return base + ((uint64_t(1) << shift) - 1);
+    }
+};
+
+/* one reading of the clock, and of the counters if there are any */
+struct PhaseStamp {
+    uint64_t  ns = 0;
+    HwReading hw{};
+};
+
+class PhaseProfile {
+public:
+    static constexpr size_t DEPTH_CLASSES = 33;        // 0, then one per power of two
+
+    static uint64_t clock_ns() { return TraceWriter::clock_ns(); }
+
+    /* also write every sample to t (nullptr: stop) */
+    void trace_to(TraceWriter* t) { trace = t; }
+
+    /* also count hardware events over every sample, if c opened */
+    void count_with(const PerfCounters* c) { hw = c && c->available() ? c : nullptr; }
+
+    /* queue depth the next samples are filed under */
+    void set_depth(size_t d) { depth = depth_class(d); }
+
+    /* simulated time of the current call */
+    void set_now(double t) { now = t; }
+
+    PhaseStamp stamp() const
+    {
+        PhaseStamp s;
+        if (hw) hw->read(s.hw);
+        s.ns = clock_ns();
+        return s;
+    }
+
+    /* phase p ran from a to b */
+    void add(Phase p, const PhaseStamp& a, const PhaseStamp& b)
+    {
+        size_t i = static_cast<size_t>(p);
+        uint64_t ns = b.ns - a.ns;
+        all[i].add(ns, a.hw, b.hw);
+        auto& h = by_depth[i * DEPTH_CLASSES + depth];
+        if (!h) h = std::make_unique<Stats>();
+        h->add(ns, a.hw, b.hw);
+        if (trace) trace->span(static_cast<uint16_t>(p), a.ns, ns, p == Phase::CALL ? now : NAN);
+    }
+
+    void count(Counter c, double v)
+    {
+        if (trace) trace->counter(static_cast<uint16_t>(c), clock_ns(), v);
+    }
+
+    /* PREFIX.json and PREFIX.csv; false if either cannot be written.
+       Counter columns are means per sample, empty without counters;
+       `counters` says why there are none.                            */
+    bool write(const std::string& prefix, const std::string& counters) const
+    {
+        FILE* js  = std::fopen((prefix + ".json").c_str(), "w");
+        FILE* csv = std::fopen((prefix + ".csv").c_str(), "w");
+        bool ok = js && csv;
+        if (ok) {
+            std::fprintf(js, "{\"clock\": \"steady_clock\", \"unit\": \"ns\", \"counters\": \"%s\", "
+                             "\"phases\": [", counters.c_str());
+            std::fprintf(csv, "phase,depth_min,depth_max,count,mean_ns,p50_ns,p99_ns,max_ns");
+            for (size_t c = 0; c < size_t(HwCounter::COUNT); ++c)
+                std::fprintf(csv, ",%s", hw_counter_name(static_cast<HwCounter>(c)));
+            std::fprintf(csv, ",ipc,multiplexed,unmeasured\n");
+            const char* sep = "";
+            for (size_t i = 0; i < size_t(Phase::COUNT); ++i) {
+                const char* name = phase_name(static_cast<Phase>(i));
+                std::fprintf(js, "%s\n  {\"phase\": \"%s\", ", sep, name);
+                json_stats(js, all[i]);
+                std::fprintf(js, ", \"by_depth\": [");
+                csv_row(csv, name, "all", "all", all[i]);
+                const char* dsep = "";
+                for (size_t d = 0; d < DEPTH_CLASSES; ++d) {
+                    const auto& h = by_depth[i * DEPTH_CLASSES + d];
+                    if (!h) continue;
+                    uint64_t lo = d ? uint64_t(1) << (d - 1) : 0, hi = d ? 2 * lo - 1 : 0;
+                    std::fprintf(js, "%s\n    {\"depth_min\": %llu, \"depth_max\": %llu, ", dsep,
+                                 (unsigned long long)lo, (unsigned long long)hi);
+                    json_stats(js, *h);
+                    std::fprintf(js, "}");
+                    csv_row(csv, name, std::to_string(lo).c_str(), std::to_string(hi).c_str(), *h);
+                    dsep = ",";
+                }
+                std::fprintf(js, "]}");
+                sep = ",";
+            }
+            std::fprintf(js, "\n]}\n");
+        }
+        if (js)  ok &= std::fclose(js) == 0;
+        if (csv) ok &= std::fclose(csv) == 0;
+        return ok;
+    }
+
+private:
+    /* latencies, and hardware events summed over the samples */
+    struct Stats {
+        LogLinearHistogram lat;
+        std::array<double, size_t(HwCounter::COUNT)> hw{};
+        uint64_t multiplexed = 0;      // samples scaled up
+        uint64_t unmeasured  = 0;      // samples the counters never ran in
+
+        void add(uint64_t ns, const HwReading& a, const HwReading& b)
+        {
+            lat.add(ns);
+            if (b.enabled == a.enabled) return;   // no counters
+            if (b.running == a.running) { ++unmeasured; return; }
+            bool partial;
+            auto d = HwReading::scale(a, b, partial);
+            multiplexed += partial;
+            for (size_t c = 0; c < hw.size(); ++c) hw[c] += d[c];
+        }
+    };
+
+    Stats all[size_t(Phase::COUNT)];
+    std::unique_ptr<Stats> by_depth[size_t(Phase::COUNT) * DEPTH_CLASSES];
+    size_t              depth = 0;
+    double              now   = 0;
+    TraceWriter*        trace = nullptr;
+    const PerfCounters* hw    = nullptr;
+
+    static size_t depth_class(size_t d)
+    {
+        if (d == 0) return 0;
+        size_t c = 64 - static_cast<size_t>(__builtin_clzll(d));   // 1 → 1, 2-3 → 2, ...
+        return c < DEPTH_CLASSES ? c : DEPTH_CLASSES - 1;
+    }
+
+    double per_sample(const Stats& s, HwCounter c) const
+    {
+        uint64_t n = s.lat.count() - s.unmeasured;
+        return n ? s.hw[size_t(c)] / double(n) : 0.0;
+    }
+
+    void json_stats(FILE* f, const Stats& s) const
+    {
+        const LogLinearHistogram& h = s.lat;
+        std::fprintf(f, "\"count\": %llu, \"mean_ns\": %.1f, \"p50_ns\": %llu, "
+                        "\"p99_ns\": %llu, \"max_ns\": %llu",
+                     (unsigned long long)h.count(), h.mean(),
+                     (unsigned long long)h.quantile(0.50), (unsigned long long)h.quantile(0.99),
+                     (unsigned long long)h.max());
+        if (!hw) return;
+        for (size_t c = 0; c < size_t(HwCounter::COUNT); ++c)
+            if (hw->has(static_cast<HwCounter>(c)))
+                std::fprintf(f, ", \"%s\": %.1f", hw_counter_name(static_cast<HwCounter>(c)),
+                             per_sample(s, static_cast<HwCounter>(c)));
+        if (s.hw[size_t(HwCounter::CYCLES)])
+            std::fprintf(f, ", \"ipc\": %.3f", s.hw[size_t(HwCounter::INSTRUCTIONS)] /
+                                                s.hw[size_t(HwCounter::CYCLES)]);
+        std::fprintf(f, ", \"multiplexed\": %llu, \"unmeasured\": %llu",
+                     (unsigned long long)s.multiplexed, (unsigned long long)s.unmeasured);
+    }
+
+    void csv_row(FILE* f, const char* phase, const char* lo, const char* hi, const Stats& s) const
+    {
+        const LogLinearHistogram& h = s.lat;
+        std::fprintf(f, "%s,%s,%s,%llu,%.1f,%llu,%llu,%llu", phase, lo, hi,
+                     (unsigned long long)h.count(), h.mean(),
+                     (unsigned long long)h.quantile(0.50), (unsigned long long)h.quantile(0.99),
+                     (unsigned long long)h.max());
+        for (size_t c = 0; c < size_t(HwCounter::COUNT); ++c) {
+            if (hw && hw->has(static_cast<HwCounter>(c)))
+                std::fprintf(f, ",%.1f", per_sample(s, static_cast<HwCounter>(c)));
+            else std::fputc(',', f);
+        }
+        if (hw && s.hw[size_t(HwCounter::CYCLES)])
+            std::fprintf(f, ",%.3f", s.hw[size_t(HwCounter::INSTRUCTIONS)] /
+                                     s.hw[size_t(HwCounter::CYCLES)]);
+        else std::fputc(',', f);
+        if (hw) std::fprintf(f, ",%llu,%llu\n", (unsigned long long)s.multiplexed,
+                             (unsigned long long)s.unmeasured);
+        else    std::fprintf(f, ",,\n");
+    }
+};
+
+/* times its scope into a profile, if there is one; next() closes the
+   phase and times the following one from the same reading            */
+class PhaseTimer {
+public:
+    PhaseTimer(PhaseProfile* p, Phase ph) : prof(p), phase(ph)
+    {
+        if (prof) t0 = prof->stamp();
+    }
+    ~PhaseTimer() { stop(); }
+
+    PhaseTimer(const PhaseTimer&) = delete;
+    PhaseTimer& operator=(const PhaseTimer&) = delete;
+
+    void next(Phase ph)
+    {
+        if (!prof) return;
+        PhaseStamp t = prof->stamp();
+        if (running) prof->add(phase, t0, t);
+        phase = ph; t0 = t; running = true;
+    }
+
+    void stop()
+    {
+        if (prof && running) prof->add(phase, t0, prof->stamp());
+        running = false;
+    }
+
+private:
+    PhaseProfile* prof;
+    Phase         phase;
+    PhaseStamp    t0;
+    bool          running = true;
+};
@@ -0,0 +1,79 @@
+/**************************************************************
+ *  policies.hpp  —  queue-order keys of the EASY variants
+ *
+ *  Smaller key = served first.  policy_key<P>() is resolved at
+ *  compile time and used by the specialised engines; key_for()
+ *  is the runtime switch over the same keys.
+ *
+ *  Job must expose nb_hosts, walltime and submit_time.
+ *************************************************************/
+#pragma once
+
+#include <string>
+#include <unordered_map>
+
+enum class Policy { EXP, FCFS, LCFS, LPF, LQF, SPF, SQF };
+
+static const std::unordered_map<std::string, Policy> STR2POL = {
+    {"exp",Policy::EXP},{"fcfs",Policy::FCFS},{"lcfs",Policy::LCFS},
+    {"lpf",Policy::LPF},{"lqf",Policy::LQF},{"spf",Policy::SPF},
+    {"sqf",Policy::SQF}
+};
+
+template <Policy P, class Job>
+inline double policy_key(const Job* j, double now)
+{
+    if constexpr (P == Policy::FCFS) return  j->submit_time;
+    if constexpr (P == Policy::LCFS) return -j->submit_time;
+    if constexpr (P == Policy::SQF ) return  j->nb_hosts;
+    if constexpr (P == Policy::LQF ) return -static_cast<double>(j->nb_hosts);
+    if constexpr (P == Policy::SPF ) return  j->walltime;
+    if constexpr (P == Policy::LPF ) return -j->walltime;
+    if constexpr (P == Policy::EXP ) return -( (now - j->submit_time + j->walltime) /
+                                               j->walltime );
+}
+
+template <class Job>
+inline double key_for(const Job* j, double now, Policy p)
+{
+    switch (p) {
+        case Policy::FCFS: return policy_key<Policy::FCFS>(j, now);
+        case Policy::LCFS: return policy_key<Policy::LCFS>(j, now);
+        case Policy::SQF : return policy_key<Policy::SQF >(j, now);
+        case Policy::LQF : return policy_key<Policy::LQF >(j, now);
+        case Policy::SPF : return policy_key<Policy::SPF >(j, now);
+        case Policy::LPF : return policy_key<Policy::LPF >(j, now);
+        case Policy::EXP : return policy_key<Policy::EXP >(j, now);
+    }
+    return 0;
+}
+
+/* the same keys as key_program.hpp expressions (same IEEE operations) */
+inline const char* policy_expression(Policy p)
+{
+    switch (p) {
+        case Policy::FCFS: return "submit_time";
+        case Policy::LCFS: return "-submit_time";
+        case Policy::SQF : return "nb_hosts";
+        case Policy::LQF : return "-nb_hosts";
+        case Policy::SPF : return "walltime";
+        case Policy::LPF : return "-walltime";
+        case Policy::EXP : return "-((submit_age+walltime)/walltime)";
+    }
+    return "submit_time";
+}
+
+/* key of a time-independent policy, as a JobOrder key type */
+template <Policy P, class Job>
+struct StaticKey {
+    static_assert(P != Policy::EXP, "EXP depends on the current time");
+    static double key(const Job* j) { return policy_key<P>(j, 0.0); }
+};
+
+/* EXP keys are lines in time: -(now - submit + walltime) / walltime */
+template <class Job>
+struct ExpLine {
+    static double key(const Job* j, double t) { return policy_key<Policy::EXP>(j, t); }
+    static double intercept(const Job* j)     { return j->submit_time / j->walltime - 1.0; }
+    static double slope(const Job* j)         { return -1.0 / j->walltime; }
+};
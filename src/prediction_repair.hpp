@@ -0,0 +1,73 @@
+/**************************************************************
+ *  prediction_repair.hpp  —  running jobs that outlive their
+ *                            predicted runtime (#pred)
+ *
+ *  A job started on a prediction shorter than its walltime is
+ *  watched until its predicted end.  Still running then, its
+ *  release step moves to the end of its walltime, the kill
+ *  bound, so reservations stop counting on hosts it holds.  The
+ *  caller is asked to be woken at the earliest instant watched.
+ *
+ *      watch    O(log n)
+ *      repair   O(k log n) for the k jobs due
+ *
+ *  Table is a JobTable whose records expose req_walltime;
+ *  Profile has remove(t, n) and add(t, n) (AvailabilityProfile).
+ *************************************************************/
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+
+#include "job_table.hpp"
+
+class PredictionRepair {
+public:
+    /* job h, planned to end at `end`, is checked then */
+    void watch(double end, JobHandle h) { due.push(Expiry{end, h}); }
+
+    /* moves to its walltime the release of every job still running past
+       its predicted end at `now`; true if any moved.  wake(t) is called
+       when the earliest instant still watched changes.                  */
+    template <class Table, class Profile, class Wake>
+    bool repair(double now, Table& jobs, Profile& profile, Wake wake)
+    {
+        bool moved = false;
+        while (!due.empty() && due.top().t <= now) {
+            Expiry x = due.top(); due.pop();
+            if (!jobs.alive(x.h)) continue;
+            auto& run = jobs.running(x.h);
+            if (!run.active || run.end != x.t) continue;
+            profile.remove(run.end, run.nb_hosts);
+            run.end = run.start + jobs.record(x.h).req_walltime;
+            profile.add(run.end, run.nb_hosts);
+            ++nb_repaired;
+            moved = true;
+        }
+        if (!due.empty() && due.top().t != wake_t) {
+            wake_t = due.top().t;
+            wake(wake_t);
+        }
+        return moved;
+    }
+
+    uint64_t repaired() const { return nb_repaired; }
+
+    void report(const char* who, const char* predictor) const
+    {
+        std::printf("%s: predictor=%s repaired=%llu\n", who, predictor,
+                    (unsigned long long)nb_repaired);
+    }
+
+    void clear()
+    {
+        due = ExpiryQueue();
+        wake_t = -1;
+        nb_repaired = 0;
+    }
+
+private:
+    ExpiryQueue due;
+    double      wake_t = -1;        // last wake asked for
+    uint64_t    nb_repaired = 0;    // predictions a job outlived
+};
@@ -0,0 +1,73 @@
+/**************************************************************
+ *  quantile_sketch.hpp  —  streaming quantiles of non-negative
+ *                          values, with forgetting
+ *
+ *  Values are counted in buckets growing geometrically by
+ *  GAMMA, after DDSketch (Masson et al.): any quantile comes
+ *  back within a relative error of (GAMMA-1)/(GAMMA+1) ≈ 1 %,
+ *  whatever the distribution, in a fixed array.  decay() scales
+ *  every weight down, so old values fade out as the workload
+ *  changes.
+ *
+ *      add            O(1)
+ *      quantile       O(BUCKETS)
+ *      decay          O(BUCKETS)
+ *************************************************************/
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+
+class QuantileSketch {
+public:
+    static constexpr double GAMMA   = 1.02;
+    static constexpr double MIN_POS = 1.0;              // values below count as 0
+    static constexpr size_t BUCKETS = 1024;             // up to MIN_POS·GAMMA^1023 ≈ 6e8
+
+    void add(double x, double w = 1.0)
+    {
+        weights[bucket(x)] += w;
+        total += w;
+    }
+
+    /* value at quantile q in [0, 1], 0 when empty */
+    double quantile(double q) const
+    {
+        double rank = q * total, acc = 0;
+        for (size_t i = 0; i < BUCKETS; ++i) {
+            acc += weights[i];
+            if (acc > rank || (i + 1 == BUCKETS && acc > 0)) return value(i);
+        }
+        return 0;
+    }
+
+    void decay(double f)
+    {
+        for (double& w : weights) w *= f;
+        total *= f;
+    }
+
+    double weight() const { return total; }
+
+    void clear() { weights.fill(0); total = 0; }
+
+private:
+    std::array<double, BUCKETS> weights{};
+    double total = 0;
+
+    static size_t bucket(double x)
+    {
+        if (!(x >= MIN_POS)) return 0;
+        double k = std::ceil(std::log(x / MIN_POS) / std::log(GAMMA));
+        return std::min(BUCKETS - 1, static_cast<size_t>(k) + 1);
+    }
+
+    /* middle of bucket i (relative error bound on both sides) */
+    static double value(size_t i)
+    {
+        if (i == 0) return 0;
+        return MIN_POS * 2 * std::pow(GAMMA, double(i - 1)) / (GAMMA + 1);
+    }
+};
@@ -0,0 +1,310 @@
+/**************************************************************
+ *  reservation_profile.hpp  —  hosts available over time, with
+ *                              running jobs and reservations
+ *                              taken out
+ *
+ *  A step function: each breakpoint t carries the number of hosts
+ *  available on [t, next breakpoint).  Breakpoints live in a treap
+ *  keyed by time used as a dynamic segment tree: every node keeps
+ *  the min and max of its subtree, and range additions are lazy
+ *  tags pushed down on the way through.  Adjacent equal steps are
+ *  merged back, so the size follows the live reservations.
+ *
+ *      add(t0, t1, d)            O(log n)   (start, early completion)
+ *      max_over(t0, t1)          O(log n)
+ *      fits(t, q, dur)           O(log n)
+ *      until(t, q)               O(log n)
+ *      earliest(from, q, dur)    O(log n) per blocking stretch skipped,
+ *                                optionally out of a caller's budget
+ *      trim(now)                 O(log n) + nodes dropped
+ *************************************************************/
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+class ReservationProfile {
+public:
+    static constexpr double NEVER = std::numeric_limits<double>::infinity();
+
+    /* `avail` hosts from t on, nothing reserved */
+    void reset(double t, int64_t avail)
+    {
+        clear();
+        root = new_node(t, avail);
+    }
+
+    bool empty() const { return root < 0; }
+
+    /* forget the past: the first breakpoint becomes now */
+    void trim(double now)
+    {
+        if (root < 0) return;
+        int32_t l, r;
+        split(root, now, l, r);                       // l: < now, r: >= now
+        if (l < 0) { root = r; return; }
+        if (r < 0 || leftmost(r) != now) r = merge(new_node(now, rightmost_val(l)), r);
+        drop(l);
+        root = r;
+    }
+
+    /* d hosts more (d < 0: fewer) on [t0, t1); t1 may be NEVER */
+    void add(double t0, double t1, int64_t d)
+    {
+        if (root < 0 || d == 0 || !(t0 < t1)) return;
+        ensure(t0);
+        if (t1 != NEVER) ensure(t1);
+        int32_t l, m, r;
+        split(root, t0, l, m);
+        split(m, t1, m, r);
+        apply(m, d);
+        root = merge(merge(l, m), r);
+        coalesce(t0);
+        if (t1 != NEVER) coalesce(t1);
+    }
+
+    /* hosts available at t */
+    int64_t at(double t)
+    {
+        int32_t n = root, best = -1;
+        while (n >= 0) {
+            push(n);
+            if (nodes[n].t <= t) { best = n; n = nodes[n].r; }
+            else                   n = nodes[n].l;
+        }
+        return best < 0 ? 0 : nodes[best].v;
+    }
+
+    /* most hosts available at any instant of [t0, t1) */
+    int64_t max_over(double t0, double t1)
+    {
+        if (root < 0 || !(t0 < t1)) return 0;
+        double  fk = floor_key(t0);
+        int32_t l, m, r;
+        split(root, fk, l, m);
+        split(m, t1, m, r);
+        int64_t res = m < 0 ? 0 : nodes[m].mx;
+        root = merge(merge(l, m), r);
+        return res;
+    }
+
+    /* at least q hosts all along [t, t + dur) */
+    bool fits(double t, int64_t q, double dur)
+    {
+        double b = blocking(t, q, dur);
+        return b != b;
+    }
+
+    /* end of the stretch from t with at least q hosts: t if there are
+       fewer at t, NEVER if they never run short                      */
+    double until(double t, int64_t q)
+    {
+        if (root < 0) return t;
+        double b = first_below(root, floor_key(t), NEVER, q);
+        if (b != b) return NEVER;
+        return std::max(b, t);
+    }
+
+    /* earliest t >= from with at least q hosts all along [t, t + dur);
+       each stretch skipped costs one unit of *budget, NEVER once spent  */
+    double earliest(double from, int64_t q, double dur, size_t* budget = nullptr)
+    {
+        double t = from;
+        for (;;) {
+            if (budget) { if (*budget == 0) return NEVER; --*budget; }
+            double b = blocking(t, q, dur);
+            if (b != b) return t;                         // NaN: no blocking step
+            t = first_atleast(root, b, q);
+            if (t == NEVER) return NEVER;
+        }
+    }
+
+    size_t size() const { return nodes.size() - free_list.size(); }
+
+    void clear()
+    {
+        nodes.clear(); free_list.clear(); root = -1;
+    }
+
+private:
+    struct Node {
+        double   t;
+        int64_t  v;             // hosts on [t, next)
+        int64_t  mn, mx;        // over the subtree, tag included
+        int64_t  lz;            // still to add to both children
+        uint32_t prio;
+        int32_t  l, r;
+    };
+
+    std::vector<Node>    nodes;
+    std::vector<int32_t> free_list;
+    int32_t              root = -1;
+    uint32_t             seed = 0x9e3779b9u;
+
+    int32_t new_node(double t, int64_t v)
+    {
+        seed ^= seed << 13; seed ^= seed >> 17; seed ^= seed << 5;   // xorshift32
+        Node nd{t, v, v, v, 0, seed, -1, -1};
+        if (!free_list.empty()) {
+            int32_t n = free_list.back(); free_list.pop_back();
+            nodes[n] = nd;
+            return n;
+        }
+        nodes.push_back(nd);
+        return static_cast<int32_t>(nodes.size() - 1);
+    }
+
+    void apply(int32_t n, int64_t d)
+    {
+        if (n < 0) return;
+        Node& nd = nodes[n];
+        nd.v += d; nd.mn += d; nd.mx += d; nd.lz += d;
+    }
+
+    void push(int32_t n)
+    {
+        Node& nd = nodes[n];
+        if (nd.lz == 0) return;
+        apply(nd.l, nd.lz); apply(nd.r, nd.lz);
+        nd.lz = 0;
+    }
+
+    void pull(int32_t n)
+    {
+        Node& nd = nodes[n];
+        nd.mn = nd.mx = nd.v;
+        if (nd.l >= 0) { nd.mn = std::min(nd.mn, nodes[nd.l].mn); nd.mx = std::max(nd.mx, nodes[nd.l].mx); }
+        if (nd.r >= 0) { nd.mn = std::min(nd.mn, nodes[nd.r].mn); nd.mx = std::max(nd.mx, nodes[nd.r].mx); }
+    }
+
+    /* l: keys < t, r: keys >= t */
+    void split(int32_t n, double t, int32_t& l, int32_t& r)
+    {
+        if (n < 0) { l = r = -1; return; }
+        push(n);
+        if (nodes[n].t < t) { split(nodes[n].r, t, nodes[n].r, r); l = n; }
+        else                { split(nodes[n].l, t, l, nodes[n].l); r = n; }
+        pull(n);
+    }
+
+    int32_t merge(int32_t a, int32_t b)
+    {
+        if (a < 0) return b;
+        if (b < 0) return a;
+        if (nodes[a].prio > nodes[b].prio) {
+            push(a); nodes[a].r = merge(nodes[a].r, b); pull(a); return a;
+        }
+        push(b); nodes[b].l = merge(a, nodes[b].l); pull(b); return b;
+    }
+
+    double leftmost(int32_t n) const
+    {
+        while (nodes[n].l >= 0) n = nodes[n].l;
+        return nodes[n].t;
+    }
+
+    int64_t rightmost_val(int32_t n)
+    {
+        for (;;) {
+            push(n);
+            if (nodes[n].r < 0) return nodes[n].v;
+            n = nodes[n].r;
+        }
+    }
+
+    /* last breakpoint <= t (the first one if t precedes them all) */
+    double floor_key(double t) const
+    {
+        int32_t n = root;
+        double  best = -NEVER;
+        while (n >= 0) {
+            if (nodes[n].t <= t) { best = nodes[n].t; n = nodes[n].r; }
+            else                   n = nodes[n].l;
+        }
+        return best == -NEVER ? leftmost(root) : best;
+    }
+
+    /* make t a breakpoint, with the value of the step it falls in */
+    void ensure(double t)
+    {
+        int32_t n = root;
+        while (n >= 0 && nodes[n].t != t) n = (t < nodes[n].t) ? nodes[n].l : nodes[n].r;
+        if (n >= 0) return;
+        int64_t v = at(t);
+        int32_t l, r;
+        split(root, t, l, r);
+        root = merge(merge(l, new_node(t, v)), r);
+    }
+
+    /* drop breakpoint t if it repeats the step before it */
+    void coalesce(double t)
+    {
+        int32_t l, m;
+        split(root, t, l, m);
+        if (l < 0 || m < 0 || leftmost(m) != t) { root = merge(l, m); return; }
+        int64_t before = rightmost_val(l);
+        int32_t first = cut_first(m);                     // m now holds keys > t
+        if (nodes[first].v == before) { free_list.push_back(first); root = merge(l, m); }
+        else root = merge(merge(l, first), m);
+    }
+
+    /* detach the leftmost node of the treap rooted at n */
+    int32_t cut_first(int32_t& n)
+    {
+        push(n);
+        if (nodes[n].l < 0) {
+            int32_t first = n;
+            n = nodes[n].r;
+            nodes[first].r = -1; pull(first);
+            return first;
+        }
+        int32_t first = cut_first(nodes[n].l);
+        pull(n);
+        return first;
+    }
+
+    void drop(int32_t n)
+    {
+        if (n < 0) return;
+        drop(nodes[n].l); drop(nodes[n].r);
+        free_list.push_back(n);
+    }
+
+    /* first breakpoint of [t, t + dur) with fewer than q hosts, NaN if none */
+    double blocking(double t, int64_t q, double dur)
+    {
+        double end = t + dur;
+        if (!(end > t)) end = std::nextafter(t, NEVER);   // the step at t still counts
+        return first_below(root, floor_key(t), end, q);
+    }
+
+    /* first key in [lo, hi) whose step has fewer than q hosts, NaN if none */
+    double first_below(int32_t n, double lo, double hi, int64_t q)
+    {
+        if (n < 0 || nodes[n].mn >= q) return std::numeric_limits<double>::quiet_NaN();
+        push(n);
+        const Node& nd = nodes[n];
+        if (nd.t < lo)   return first_below(nd.r, lo, hi, q);
+        if (nd.t >= hi)  return first_below(nd.l, lo, hi, q);
+        double k = first_below(nd.l, lo, hi, q);
+        if (k == k) return k;
+        if (nd.v < q) return nd.t;
+        return first_below(nd.r, lo, hi, q);
+    }
+
+    /* first key > lo whose step has at least q hosts, NEVER if none */
+    double first_atleast(int32_t n, double lo, int64_t q)
+    {
+        if (n < 0 || nodes[n].mx < q) return NEVER;
+        push(n);
+        const Node& nd = nodes[n];
+        if (nd.t <= lo) return first_atleast(nd.r, lo, q);
+        double k = first_atleast(nd.l, lo, q);
+        if (k != NEVER) return k;
+        if (nd.v >= q) return nd.t;
+        return first_atleast(nd.r, lo, q);
+    }
+};
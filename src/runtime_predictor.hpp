@@ -0,0 +1,102 @@
+/**************************************************************
+ *  runtime_predictor.hpp  —  runtimes to plan with instead of
+ *                            the requested walltimes
+ *
+ *  Requested walltimes are upper bounds, often 1.2–4× the actual
+ *  runtime, which pushes shadow times out and keeps backfilling
+ *  timid.  A predictor gives the runtime the scheduler plans with
+ *  (never above the walltime, which stays the kill bound) and
+ *  learns from every completion.
+ *
+ *      "avg"   ShapeAverage: the walltime scaled by the mean
+ *              runtime / walltime ratio of the last WINDOW jobs of
+ *              the same shape (log2 nb_hosts, log2 walltime), after
+ *              Tsafrir et al.'s average of recent runtimes; its
+ *              bound is the largest ratio the shape ever had, once
+ *              BOUND_MIN of its jobs were seen
+ *
+ *  A prediction that runs out before the job does is the caller's
+ *  to repair (the job then counts for its full walltime).
+ *************************************************************/
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+struct RuntimePredictor {
+    virtual ~RuntimePredictor() = default;
+
+    /* runtime to plan with, in (0, walltime] */
+    virtual double predict(uint32_t nb_hosts, double walltime) = 0;
+
+    /* a runtime the job is unlikely to outlive, for decisions that are
+       costly when wrong; the walltime when the predictor cannot tell  */
+    virtual double bound(uint32_t, double walltime) { return walltime; }
+
+    /* a job of this shape ran for `runtime` seconds */
+    virtual void learn(uint32_t nb_hosts, double walltime, double runtime) = 0;
+};
+
+class ShapeAverage final : public RuntimePredictor {
+public:
+    static constexpr uint32_t WINDOW    = 2;
+    static constexpr uint32_t BOUND_MIN = 8;
+
+    double predict(uint32_t nb_hosts, double walltime) override
+    {
+        auto it = shapes.find(shape(nb_hosts, walltime));
+        if (it == shapes.end() || it->second.n == 0) return walltime;
+        const History& h = it->second;
+        double sum = 0;
+        for (uint32_t i = 0; i < h.n; ++i) sum += h.ratio[i];
+        double p = walltime * (sum / h.n);
+        return (p > 0 && p < walltime) ? p : walltime;
+    }
+
+    /* the largest ratio the shape ever had, once it had BOUND_MIN jobs */
+    double bound(uint32_t nb_hosts, double walltime) override
+    {
+        auto it = shapes.find(shape(nb_hosts, walltime));
+        if (it == shapes.end() || it->second.seen < BOUND_MIN) return walltime;
+        double p = walltime * it->second.longest;
+        return (p > 0 && p < walltime) ? p : walltime;
+    }
+
+    void learn(uint32_t nb_hosts, double walltime, double runtime) override
+    {
+        if (!(walltime > 0)) return;
+        History& h = shapes[shape(nb_hosts, walltime)];
+        h.ratio[h.next] = std::clamp(runtime / walltime, 0.0, 1.0);
+        h.next = (h.next + 1) % WINDOW;
+        h.n    = std::min(h.n + 1, WINDOW);
+        h.longest = std::max(h.longest, h.ratio[(h.next + WINDOW - 1) % WINDOW]);
+        if (h.seen < BOUND_MIN) ++h.seen;
+    }
+
+private:
+    struct History {
+        double   ratio[WINDOW] = {};
+        uint32_t next = 0, n = 0;
+        double   longest = 0;      // largest ratio seen
+        uint32_t seen = 0;         // jobs learnt, up to BOUND_MIN
+    };
+    std::unordered_map<uint32_t, History> shapes;
+
+    static uint32_t shape(uint32_t nb_hosts, double walltime)
+    {
+        uint32_t hc = nb_hosts ? 31 - static_cast<uint32_t>(__builtin_clz(nb_hosts)) : 0;
+        uint32_t wc = walltime >= 1.0 ? static_cast<uint32_t>(std::ilogb(walltime)) : 0;
+        return hc << 8 | std::min<uint32_t>(wc, 255);
+    }
+};
+
+/* predictor by name, nullptr if unknown */
+inline std::unique_ptr<RuntimePredictor> make_predictor(const std::string& name)
+{
+    if (name == "avg") return std::make_unique<ShapeAverage>();
+    return nullptr;
+}
@@ -0,0 +1,74 @@
+/**************************************************************
+ *  slab_pool.hpp  —  fixed-size records in chunked slabs
+ *
+ *  Records are addressed by a dense index and never move: the
+ *  pool grows by whole chunks and recycled indices are handed
+ *  out again before a new chunk is carved.  Memory therefore
+ *  follows the peak number of live records, not the total ever
+ *  acquired.  Counters are kept for the end-of-run report.
+ *************************************************************/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+struct SlabStats {
+    uint64_t acquired = 0;     // acquire() calls
+    uint64_t recycled = 0;     // acquire() served from the free list
+    uint64_t released = 0;
+    size_t   live     = 0;
+    size_t   peak     = 0;
+    size_t   chunks   = 0;
+};
+
+template <class T, uint32_t ChunkSize = 1024>
+class SlabPool {
+public:
+    using Stats = SlabStats;
+
+    uint32_t acquire()
+    {
+        ++st.acquired;
+        uint32_t i;
+        if (!spare.empty()) {
+            i = spare.back(); spare.pop_back();
+            ++st.recycled;
+        } else {
+            if (used == chunks.size() * ChunkSize) {
+                chunks.emplace_back(new T[ChunkSize]);
+                st.chunks = chunks.size();
+                spare.reserve(chunks.size() * ChunkSize);   // release() never grows it
+            }
+            i = used++;
+        }
+        if (++st.live > st.peak) st.peak = st.live;
+        return i;
+    }
+
+    /* the record keeps its content; the next owner overwrites it */
+    void release(uint32_t i)
+    {
+        spare.push_back(i);
+        ++st.released;
+        --st.live;
+    }
+
+    T&       operator[](uint32_t i)       { return chunks[i / ChunkSize][i % ChunkSize]; }
+    const T& operator[](uint32_t i) const { return chunks[i / ChunkSize][i % ChunkSize]; }
+
+    uint32_t     extent() const { return used; }     // indices handed out so far
+    const Stats& stats()  const { return st; }
+
+    void clear()
+    {
+        chunks.clear(); spare.clear(); used = 0; st = Stats();
+    }
+
+private:
+    std::vector<std::unique_ptr<T[]>> chunks;
+    std::vector<uint32_t>             spare;
+    uint32_t                          used = 0;
+    Stats                             st;
+};
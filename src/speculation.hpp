@@ -0,0 +1,170 @@
+/**************************************************************
+ *  speculation.hpp  —  speculative backfills (#spec): jobs
+ *                      started across the shadow time on a
+ *                      runtime bound, killed if they overrun
+ *                      into the head's reservation, and run
+ *                      again
+ *
+ *  A speculative job starts with a kill instant, the shadow time
+ *  it crosses, and its release step planned there.  At that
+ *  instant, still running, it is killed only if the head of the
+ *  queue is waiting and its reservation needs the job's hosts:
+ *  planned at the end of its walltime instead, the job would put
+ *  the reservation later.  The others are spared, their step
+ *  moved to their walltime, and run on as ordinary jobs.  The
+ *  jobs due are tried for sparing in decreasing host-seconds
+ *  done, so those killed are each needed and waste the least.
+ *
+ *  A killed job is run again: Batsim does not run a job id
+ *  twice, so it is registered anew as "<id>#r<n>" with the same
+ *  profile, and queued with its first submission time and rank.
+ *  Registration stays open while a job could still be killed,
+ *  that is until every static job is submitted, none waits and
+ *  no speculative one runs.
+ *
+ *  Host-seconds of the speculative jobs that completed count as
+ *  gained, those of the killed ones as wasted.
+ *
+ *      started          O(log n)
+ *      kill_overruns    O(k log n + k p) for the k jobs due,
+ *                       p release steps
+ *
+ *  Table is a JobTable whose records expose kill_at and
+ *  req_walltime; Profile has remove(t, n), add(t, n) and
+ *  earliest(now, free, need) (AvailabilityProfile).
+ *************************************************************/
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "job_table.hpp"
+
+class Speculation {
+public:
+    /* job h started speculatively, to be killed at kill_at */
+    void started(JobHandle h, double kill_at)
+    {
+        kills.push(Expiry{kill_at, h});
+        ++nb_started; ++live;
+    }
+
+    /* a speculative job ended on its own, or was killed, after host_s */
+    void completed(double host_s) { ++nb_done;   --live; gained += host_s; }
+    void killed(double host_s)    { ++nb_killed; --live; wasted += host_s; }
+
+    /* At `now`, the speculative jobs due: with the head waiting for
+       `need` hosts (0 if none waits) and `free` of them free, those
+       its reservation needs go to kill(ids), the others are spared.
+       True if a release step moved.  wake(t) when the next kill
+       instant changes.                                               */
+    template <class Table, class Profile, class Kill, class Wake>
+    bool kill_overruns(double now, Table& jobs, Profile& profile, uint32_t free, uint32_t need,
+                       Kill kill, Wake wake)
+    {
+        due.clear();
+        while (!kills.empty() && kills.top().t <= now) {
+            Expiry x = kills.top(); kills.pop();
+            if (!jobs.alive(x.h)) continue;
+            if (!jobs.running(x.h).active || jobs.record(x.h).kill_at != x.t) continue;
+            due.push_back(x.h);
+        }
+        std::sort(due.begin(), due.end(), [&](JobHandle a, JobHandle b) {
+            const auto &ra = jobs.running(a), &rb = jobs.running(b);
+            return (now - ra.start) * ra.nb_hosts > (now - rb.start) * rb.nb_hosts;
+        });
+
+        ids.clear();
+        const bool   waiting = need > free;
+        const double reserve = waiting ? profile.earliest(now, free, need) : now;
+        for (JobHandle h : due) {
+            auto& run = jobs.running(h);
+            auto& rec = jobs.record(h);
+            const double end = run.start + rec.req_walltime;
+            profile.remove(run.end, run.nb_hosts);
+            profile.add(end, run.nb_hosts);
+            if (waiting && profile.earliest(now, free, need) > reserve) {
+                profile.remove(end, run.nb_hosts);      // needed: killed at its step
+                profile.add(run.end, run.nb_hosts);
+                ids.push_back(jobs.id(h));
+                continue;
+            }
+            run.end     = end;
+            rec.kill_at = HUGE_VAL;
+            ++nb_spared; --live;
+        }
+        if (!ids.empty()) kill(ids);
+        if (!kills.empty() && kills.top().t != wake_t) {
+            wake_t = kills.top().t;
+            wake(wake_t);
+        }
+        return ids.size() < due.size();
+    }
+
+    /* the id a killed job runs again under; `n` is how many times it ran
+       before, and comes back incremented                               */
+    const std::string& requeue_id(const std::string& id, uint32_t& n)
+    {
+        const std::string tail = n ? "#r" + std::to_string(n) : std::string();
+        rid.assign(id, 0, id.size() - tail.size());
+        rid += "#r" + std::to_string(++n);
+        ++nb_requeued;
+        return rid;
+    }
+
+    /* profiles, interned: a record keeps the index, to register again */
+    uint32_t profile_index(const std::string& name)
+    {
+        auto [it, added] = profile_ids.emplace(name, uint32_t(profiles.size()));
+        if (added) profiles.push_back(name);
+        return it->second;
+    }
+    const std::string& profile(uint32_t i) const { return profiles[i]; }
+
+    /* registration: open until nothing can be killed any more */
+    void all_submitted() { statics_in = true; }
+    bool registering() const { return open; }
+    bool may_close(size_t pending) const { return open && statics_in && pending == 0 && live == 0; }
+    void close() { open = false; }
+
+    void report(const char* who) const
+    {
+        std::printf("%s: spec backfilled=%llu completed=%llu spared=%llu killed=%llu "
+                    "requeued=%llu gained=%.0f host-s wasted=%.0f host-s (%.1f%% of gained)\n", who,
+                    (unsigned long long)nb_started, (unsigned long long)nb_done,
+                    (unsigned long long)nb_spared, (unsigned long long)nb_killed,
+                    (unsigned long long)nb_requeued, gained, wasted,
+                    gained > 0 ? 100.0 * wasted / gained : 0.0);
+    }
+
+    void clear()
+    {
+        kills = ExpiryQueue();
+        due = std::vector<JobHandle>();
+        ids = std::vector<std::string>();
+        rid = std::string();
+        profile_ids.clear(); profiles.clear();
+        wake_t = -1;
+        open = true; statics_in = false;
+        nb_started = nb_done = nb_spared = nb_killed = nb_requeued = live = 0;
+        gained = wasted = 0;
+    }
+
+private:
+    ExpiryQueue              kills;       // speculative jobs by kill instant
+    std::vector<JobHandle>   due;         // reused by kill_overruns()
+    std::vector<std::string> ids;         // reused by kill_overruns()
+    std::string              rid;         // reused by requeue_id()
+    std::unordered_map<std::string, uint32_t> profile_ids;
+    std::vector<std::string> profiles;
+    double                   wake_t = -1; // last wake asked for
+    bool open = true, statics_in = false; // registration open; static jobs all in
+    uint64_t nb_started = 0, nb_done = 0, nb_spared = 0, nb_killed = 0, nb_requeued = 0;
+    uint64_t live = 0;                    // speculative jobs running
+    double   gained = 0, wasted = 0;      // host-seconds
+};
@@ -0,0 +1,114 @@
+/**************************************************************
+ *  threshold_tuner.hpp  —  the aging threshold steered toward
+ *                          a target p99 wait (#tune)
+ *
+ *  Once per PERIOD the threshold is scaled by sqrt(target / p99)
+ *  of the decayed waits of started jobs and the waits so far of
+ *  those still pending, unless p99 is within DEADBAND of the
+ *  target.  Lower, it ages jobs sooner; jobs already aged stay
+ *  so when it rises.  Each change is printed with the inputs it
+ *  was computed from, in full precision.
+ *
+ *  The threshold stays within [target/100, target], and is held
+ *  rather than pushed further when it is pinned at a bound or
+ *  when, after a move the same way, p99 got no closer to the
+ *  target than it was the period before: the waits are then not
+ *  the threshold's to fix.  After REARM periods held so, it moves
+ *  again, so that a load that rose and stays up is still tracked.
+ *  Entering that state is printed once, and the periods spent in
+ *  it are reported at the end.
+ *************************************************************/
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+
+#include "quantile_sketch.hpp"
+
+class ThresholdTuner {
+public:
+    static constexpr double PERIOD     = 3600.0;
+    static constexpr double HALF_LIFE  = 24 * 3600.0;
+    static constexpr double MIN_WEIGHT = 50.0;      // samples before any change
+    static constexpr double DEADBAND   = 0.05;
+    static constexpr uint32_t REARM    = 6;         // held periods before moving again
+
+    /* p99 wait to hold (s); <= 0 ⇒ off */
+    void   set_target(double p99) { target = p99; }
+    bool   on() const { return target > 0; }
+    double p99() const { return waits.quantile(0.99); }
+
+    /* a job started after waiting `wait` seconds */
+    void started(double wait) { waits.add(wait); }
+
+    bool due(double now) const { return now >= next; }
+
+    /* the threshold to use from `now`; pending(f) calls f(wait) for every
+       job still waiting.  Changes are printed, prefixed by `who`.        */
+    template <class Pending>
+    double tune(double now, double threshold, Pending pending, const char* who)
+    {
+        next = now + PERIOD;
+        waits.decay(std::exp2(-PERIOD / HALF_LIFE));
+
+        /* a queue that starts nothing must still raise p99 */
+        QuantileSketch all = waits;
+        pending([&](double w) { all.add(w); });
+        if (all.weight() < MIN_WEIGHT) return threshold;
+
+        double q     = all.quantile(0.99);
+        double prev  = prev_p99;
+        prev_p99     = q;
+        double ratio = target / std::max(q, 1.0);
+        if (std::fabs(ratio - 1.0) < DEADBAND) { held = false; held_for = 0; return threshold; }
+        int    dir = ratio < 1 ? -1 : 1;
+        double t   = std::clamp(threshold * std::sqrt(std::clamp(ratio, 0.25, 4.0)),
+                                target / 100, target);
+        bool no_effect = dir == last_dir && held_for < REARM &&
+                         std::fabs(std::log(q / target)) >= std::fabs(std::log(prev / target));
+        if (t == threshold || no_effect) {
+            if (!held)
+                std::printf("%s: tune held now=%.17g p99=%.17g weight=%.17g threshold=%.17g (%s)\n",
+                            who, now, q, all.weight(), threshold,
+                            t == threshold ? "at its bound" : "last move did not help");
+            held = true;
+            ++held_for;
+            ++nb_held;
+            return threshold;
+        }
+        std::printf("%s: tune now=%.17g p99=%.17g weight=%.17g threshold=%.17g -> %.17g\n",
+                    who, now, q, all.weight(), threshold, t);
+        held     = false;
+        held_for = 0;
+        last_dir = dir;
+        ++nb_tunes;
+        return t;
+    }
+
+    void report(const char* who, double threshold) const
+    {
+        std::printf("%s: tune changes=%llu held=%llu threshold=%.17g p99=%.17g\n", who,
+                    (unsigned long long)nb_tunes, (unsigned long long)nb_held, threshold, p99());
+    }
+
+    void clear()
+    {
+        waits.clear();
+        target = -1; next = 0;
+        nb_tunes = nb_held = 0;
+        held = false; held_for = 0; prev_p99 = 0; last_dir = 0;
+    }
+
+private:
+    QuantileSketch waits;               // of started jobs, forgetting the old ones
+    double   target   = -1;
+    double   next     = 0;              // next tune
+    uint64_t nb_tunes = 0;
+    uint64_t nb_held  = 0;              // periods the threshold was held, saturated
+    bool     held     = false;
+    uint32_t held_for = 0;              // periods held in a row
+    double   prev_p99 = 0;              // p99 of the period before
+    int      last_dir = 0;              // -1 lowered, +1 raised, 0 never moved
+};
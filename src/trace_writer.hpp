@@ -0,0 +1,204 @@
+/**************************************************************
+ *  trace_writer.hpp  —  Chrome / Perfetto trace of the decision
+ *                       calls, written by a background thread
+ *
+ *  The scheduler thread only stores fixed-size records into a
+ *  preallocated single-producer ring (no allocation, no
+ *  formatting, no lock); a writer thread drains it every few
+ *  milliseconds, or as soon as it is half full, and formats the
+ *  records as Trace Event Format JSON:
+ *      span      "X" event, steady_clock start and duration
+ *      counter   "C" event, one value
+ *  ui.perfetto.dev and chrome://tracing nest the spans by time.
+ *  A record finding the ring full is dropped and counted, so
+ *  the scheduler never waits for the disk.
+ *
+ *  Names are indexes into a table given at construction, whose
+ *  strings must outlive the writer.
+ *************************************************************/
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class TraceWriter {
+public:
+    static constexpr size_t CAPACITY = size_t(1) << 18;          // records, 8 MiB
+    static constexpr auto   PERIOD   = std::chrono::milliseconds(20);
+
+    /* opens path; ok() is false if it cannot be written */
+    TraceWriter(const std::string& path, std::vector<const char*> names)
+        : names(std::move(names)), ring(new Record[CAPACITY]),
+          out(std::fopen(path.c_str(), "w")), origin(clock_ns())
+    {
+        if (!out) return;
+        std::fprintf(out, "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [\n"
+                          "{\"ph\": \"M\", \"pid\": 1, \"name\": \"process_name\", "
+                          "\"args\": {\"name\": \"easy-unified\"}},\n"
+                          "{\"ph\": \"M\", \"pid\": 1, \"tid\": 1, \"name\": \"thread_name\", "
+                          "\"args\": {\"name\": \"take_decisions\"}}");
+        writer = std::thread([this]{ drain_loop(); });
+    }
+
+    ~TraceWriter()
+    {
+        if (!out) return;
+        {
+            std::lock_guard<std::mutex> lk(mu);
+            stopping = true;
+        }
+        wake.notify_one();
+        writer.join();
+        std::fprintf(out, "\n]}\n");
+        std::fclose(out);
+    }
+
+    TraceWriter(const TraceWriter&) = delete;
+    TraceWriter& operator=(const TraceWriter&) = delete;
+
+    /* the timestamps records take, steady_clock in ns */
+    static uint64_t clock_ns()
+    {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    bool     ok()      const { return out != nullptr; }
+    uint64_t written() const { return head.load(std::memory_order_relaxed); }
+    uint64_t dropped() const { return nb_dropped; }
+
+    /* name ran from t0 for dur ns; arg, if not NaN, is shown with it */
+    void span(uint16_t name, uint64_t t0, uint64_t dur, double arg = NAN)
+    {
+        push(Record{t0, dur, arg, SPAN, name});
+    }
+
+    void counter(uint16_t name, uint64_t t, double value)
+    {
+        push(Record{t, 0, value, COUNTER, name});
+    }
+
+private:
+    enum Kind : uint16_t { SPAN, COUNTER };
+    struct Record {
+        uint64_t t;
+        uint64_t dur;
+        double   value;
+        uint16_t kind;
+        uint16_t name;
+    };
+
+    std::vector<const char*>  names;
+    std::unique_ptr<Record[]> ring;
+    FILE*                     out;
+    uint64_t                  origin;       // trace time 0
+
+    /* head: producer only; tail: writer only; each side caches the other's */
+    alignas(64) std::atomic<uint64_t> head{0};
+    uint64_t                          tail_seen  = 0;
+    uint64_t                          nb_dropped = 0;
+    alignas(64) std::atomic<uint64_t> tail{0};
+    std::vector<char>                 text;        // writer's formatting buffer
+
+    std::thread             writer;
+    std::mutex              mu;
+    std::condition_variable wake;
+    bool                    stopping = false;
+
+    void push(const Record& r)
+    {
+        if (!out) return;
+        uint64_t h = head.load(std::memory_order_relaxed);
+        if (h - tail_seen == CAPACITY) {
+            tail_seen = tail.load(std::memory_order_acquire);
+            if (h - tail_seen == CAPACITY) { ++nb_dropped; return; }
+        }
+        uint64_t used = h - tail_seen;
+        ring[h & (CAPACITY - 1)] = r;
+        head.store(h + 1, std::memory_order_release);
+        if (used + 1 == CAPACITY / 2) wake.notify_one();
+    }
+
+    void drain_loop()
+    {
+        std::unique_lock<std::mutex> lk(mu);
+        for (;;) {
+            bool last = stopping;
+            lk.unlock();
+            drain();
+            lk.lock();
+            if (last) return;
+            wake.wait_for(lk, PERIOD);
+        }
+    }
+
+    /* formats [tail, head) a batch at a time, handing each batch's slots
+       back before writing it out; printf only for non-integral values   */
+    void drain()
+    {
+        static constexpr size_t BATCH = 4096;
+        uint64_t t = tail.load(std::memory_order_relaxed);
+        uint64_t h = head.load(std::memory_order_acquire);
+        while (t != h) {
+            uint64_t e = std::min(h, t + BATCH);
+            text.clear();
+            for (; t != e; ++t) {
+                const Record& r = ring[t & (CAPACITY - 1)];
+                put(r.kind == SPAN ? ",\n{\"ph\": \"X\", \"pid\": 1, \"tid\": 1, \"name\": \""
+                                   : ",\n{\"ph\": \"C\", \"pid\": 1, \"name\": \"");
+                put(names[r.name]);
+                put("\", \"ts\": ");
+                put_us(r.t >= origin ? r.t - origin : 0);
+                if (r.kind == SPAN) {
+                    put(", \"dur\": ");
+                    put_us(r.dur);
+                    if (r.value == r.value) { put(", \"args\": {\"now\": "); put_num(r.value); put("}"); }
+                }
+                else { put(", \"args\": {\"value\": "); put_num(r.value); put("}"); }
+                put("}");
+            }
+            tail.store(t, std::memory_order_release);
+            std::fwrite(text.data(), 1, text.size(), out);
+        }
+    }
+
+    void put(const char* s)
+    {
+        while (*s) text.push_back(*s++);
+    }
+
+    void put_uint(uint64_t v, int min_digits = 1)
+    {
+        char buf[24];
+        int  n = 0;
+        do { buf[n++] = char('0' + v % 10); v /= 10; } while (v || n < min_digits);
+        while (n) text.push_back(buf[--n]);
+    }
+
+    /* ns as µs with 3 decimals */
+    void put_us(uint64_t ns)
+    {
+        put_uint(ns / 1000);
+        text.push_back('.');
+        put_uint(ns % 1000, 3);
+    }
+
+    void put_num(double v)
+    {
+        if (v >= 0 && v < 1e15 && v == double(uint64_t(v))) { put_uint(uint64_t(v)); return; }
+        char buf[32];
+        std::snprintf(buf, sizeof buf, "%.17g", v);
+        put(buf);
+    }
+};
@@ -0,0 +1,236 @@
+/**************************************************************
+ *  what_if.hpp  —  short EASY replays of a snapshot of the
+ *                  scheduler, one per candidate queue order
+ *
+ *  A WhatIfSnapshot is taken once per evaluation: free hosts,
+ *  the running jobs' release steps and the pending jobs, all
+ *  with predicted runtimes.  It is immutable and shared; a
+ *  replay keeps only what it changes on top of it (the jobs it
+ *  started, their release steps), so each further candidate
+ *  costs a bitmap and a few releases, not a copy of the queues.
+ *
+ *  A replay runs the EASY pass (head, else its reservation and
+ *  backfilling in backfill order) at every release up to the
+ *  horizon; no job arrives meanwhile.  Predicted runtimes are
+ *  used both to plan and as the runtimes.  Each job looked at
+ *  or sorted is charged to a work budget, and a replay running
+ *  out of it gives no score, so an evaluation costs a bounded,
+ *  deterministic amount of work.
+ *
+ *  Scores, smaller is better, over the snapshot's pending jobs
+ *  (a job still waiting at the horizon counts as starting then):
+ *      WAIT      mean wait
+ *      MAX_WAIT  largest wait
+ *      BSLD      mean bounded slowdown (runtimes below 10 s
+ *                count as 10 s)
+ *************************************************************/
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "policies.hpp"
+
+struct WhatIfJob {
+    uint32_t nb_hosts;
+    double   walltime;        // predicted runtime
+    double   submit_time;
+    uint64_t seq;
+};
+
+struct WhatIfSnapshot {
+    double   now  = 0;
+    uint32_t free = 0;
+    std::vector<std::pair<double, uint32_t>> releases;   // (time >= now, hosts), sorted
+    std::vector<WhatIfJob>                   pending;    // arrival order
+};
+
+enum class WhatIfMetric { WAIT, MAX_WAIT, BSLD };
+
+struct WhatIfParams {
+    double       horizon     = 0;     // seconds replayed past the snapshot
+    double       threshold   = -1;    // aged jobs first, as the engines; <0 ⇒ off
+    bool         extra_nodes = false;
+    uint64_t     budget      = 0;     // work units of one replay
+    WhatIfMetric metric      = WhatIfMetric::WAIT;
+};
+
+class WhatIfReplay {
+public:
+    explicit WhatIfReplay(std::shared_ptr<const WhatIfSnapshot> s) : base(std::move(s)) {}
+
+    /* score of (primary p, backfill b) over the horizon, NaN past the budget */
+    double run(Policy p, Policy b, const WhatIfParams& prm)
+    {
+        const WhatIfSnapshot& s = *base;
+        const size_t n = s.pending.size();
+        started.assign((n + 63) / 64, 0);
+        added.clear();
+        bcur = acur = 0;
+        free = s.free;
+        work = 0;
+        sum = worst = 0;
+        par = &prm;
+
+        prim.resize(n); back.resize(n);
+        for (uint32_t i = 0; i < n; ++i) prim[i] = back[i] = i;
+        const bool p_moves = p == Policy::EXP || prm.threshold >= 0;
+        const bool b_moves = b == Policy::EXP;
+        if (!p_moves) order(prim, p, s.now, false);
+        if (!b_moves) order(back, b, s.now, false);
+
+        const double end = s.now + prm.horizon;
+        double t = s.now;
+        for (;;) {
+            while (next_release() <= t) free += take_release();
+            pass(t, p, b, p_moves, b_moves);
+            if (work > prm.budget) return NAN;
+            double nt = next_release();
+            if (prim.empty() || nt > end) break;
+            t = nt;
+        }
+
+        for (uint32_t i : prim) if (!is_started(i)) score(s.pending[i], end);
+        return prm.metric == WhatIfMetric::MAX_WAIT ? worst : (n ? sum / n : 0.0);
+    }
+
+private:
+    std::shared_ptr<const WhatIfSnapshot> base;
+
+    /* what this replay changed; reused from one run to the next */
+    std::vector<uint64_t> started;                        // bitmap over base->pending
+    std::vector<std::pair<double, uint32_t>> added;       // releases of started jobs, sorted
+    size_t   bcur = 0, acur = 0;                          // releases consumed so far
+    uint32_t free = 0;
+    std::vector<uint32_t> prim, back;                     // waiting jobs, in each order
+    std::vector<double>   keys;
+
+    const WhatIfParams* par = nullptr;
+    uint64_t work = 0;
+    double   sum = 0, worst = 0;
+
+    bool is_started(uint32_t i) const { return started[i / 64] >> (i % 64) & 1; }
+
+    double next_release() const
+    {
+        double t = HUGE_VAL;
+        if (bcur < base->releases.size()) t = base->releases[bcur].first;
+        if (acur < added.size()) t = std::min(t, added[acur].first);
+        return t;
+    }
+
+    uint32_t take_release()
+    {
+        bool from_base = bcur < base->releases.size() &&
+                         (acur == added.size() || base->releases[bcur].first <= added[acur].first);
+        return from_base ? base->releases[bcur++].second : added[acur++].second;
+    }
+
+    /* sort by (aged first, key, arrival) at time t */
+    void order(std::vector<uint32_t>& idx, Policy pol, double t, bool aging)
+    {
+        const std::vector<WhatIfJob>& pend = base->pending;
+        keys.resize(pend.size());
+        for (uint32_t i : idx) keys[i] = key_for(&pend[i], t, pol);
+        const double thr = par->threshold;
+        std::sort(idx.begin(), idx.end(), [&](uint32_t a, uint32_t c) {
+            if (aging) {
+                bool aa = t - pend[a].submit_time > thr, ac = t - pend[c].submit_time > thr;
+                if (aa != ac) return aa;
+            }
+            return keys[a] < keys[c] || (keys[a] == keys[c] && pend[a].seq < pend[c].seq);
+        });
+        size_t m = idx.size();
+        work += m * (1 + static_cast<uint64_t>(std::log2(m + 1.0)));
+    }
+
+    void start(uint32_t i, double t)
+    {
+        const WhatIfJob& j = base->pending[i];
+        started[i / 64] |= uint64_t(1) << (i % 64);
+        free -= j.nb_hosts;
+        std::pair<double, uint32_t> r{t + j.walltime, j.nb_hosts};
+        added.insert(std::upper_bound(added.begin() + acur, added.end(), r), r);
+        score(j, t);
+    }
+
+    void score(const WhatIfJob& j, double t)
+    {
+        double wait = t - j.submit_time;
+        worst = std::max(worst, wait);
+        sum  += par->metric == WhatIfMetric::BSLD
+                    ? std::max(1.0, (wait + j.walltime) / std::max(j.walltime, 10.0))
+                    : wait;
+    }
+
+    /* earliest time the head fits, and the hosts still spare then */
+    void reservation(double t, uint32_t need, double& shadow, uint32_t& extra)
+    {
+        uint64_t avail = free;
+        size_t   b = bcur, a = acur;
+        const auto& rel = base->releases;
+        auto next = [&]() -> const std::pair<double, uint32_t>* {
+            bool from_base = b < rel.size() && (a == added.size() || rel[b].first <= added[a].first);
+            if (from_base) return &rel[b++];
+            if (a < added.size()) return &added[a++];
+            return nullptr;
+        };
+        shadow = t;
+        while (avail < need) {
+            const auto* r = next();
+            ++work;
+            if (!r) { shadow = HUGE_VAL; break; }
+            avail += r->second; shadow = r->first;
+        }
+        extra = 0;
+        if (!par->extra_nodes || shadow == HUGE_VAL) return;
+        for (;;) {
+            double nt = HUGE_VAL;
+            if (b < rel.size()) nt = rel[b].first;
+            if (a < added.size()) nt = std::min(nt, added[a].first);
+            if (nt > shadow) break;
+            avail += next()->second;
+            ++work;
+        }
+        extra = static_cast<uint32_t>(avail - need);
+    }
+
+    void pass(double t, Policy p, Policy b, bool p_moves, bool b_moves)
+    {
+        auto gone = [this](uint32_t i) { return is_started(i); };
+        prim.erase(std::remove_if(prim.begin(), prim.end(), gone), prim.end());
+        back.erase(std::remove_if(back.begin(), back.end(), gone), back.end());
+        work += prim.size() + back.size();
+        if (p_moves) order(prim, p, t, par->threshold >= 0);
+
+        size_t h = 0;
+        while (h < prim.size() && base->pending[prim[h]].nb_hosts <= free)
+            start(prim[h++], t);
+        if (h == prim.size()) { prim.clear(); return; }
+
+        const WhatIfJob& head = base->pending[prim[h]];
+        double   shadow;
+        uint32_t extra;
+        reservation(t, head.nb_hosts, shadow, extra);
+
+        if (b_moves) {
+            back.erase(std::remove_if(back.begin(), back.end(), gone), back.end());
+            order(back, b, t, false);
+        }
+        for (uint32_t i : back) {
+            if (free == 0) break;
+            ++work;
+            const WhatIfJob& j = base->pending[i];
+            if (i == prim[h] || is_started(i) || j.nb_hosts > free) continue;
+            if (t + j.walltime > shadow) {
+                if (j.nb_hosts > extra) continue;
+                extra -= j.nb_hosts;
+            }
+            start(i, t);
+        }
+    }
+};
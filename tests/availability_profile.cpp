@@ -0,0 +1,74 @@
+/**************************************************************
+ *  availability_profile.cpp  —  AvailabilityProfile against a
+ *                               multimap of release steps
+ *
+ *  Random add / remove of release steps, many at equal times,
+ *  with earliest(), released_by() and total() compared after
+ *  each one to a scan of the sorted steps.
+ *
+ *      ./test_availability_profile [seed]
+ *************************************************************/
+#include <cstdint>
+#include <iterator>
+#include <map>
+
+#include "availability_profile.hpp"
+#include "check.hpp"
+
+/* earliest instant >= now with free + releases >= need, else the last release */
+static double naive_earliest(const std::multimap<double, uint32_t>& ref, double now,
+                             uint32_t free, uint32_t need)
+{
+    if (free >= need || ref.empty()) return now;
+    uint64_t acc = free;
+    double   t   = now;
+    for (const auto& [rt, q] : ref) {
+        acc += q; t = rt;
+        if (acc >= need) break;
+    }
+    return t > now ? t : now;
+}
+
+static uint64_t naive_released_by(const std::multimap<double, uint32_t>& ref, double t)
+{
+    uint64_t acc = 0;
+    for (const auto& [rt, q] : ref) if (rt <= t) acc += q;
+    return acc;
+}
+
+int main(int argc, char** argv)
+{
+    auto g = check::rng_from(argc, argv);
+    using check::below;
+
+    for (int round = 0; round < 20; ++round) {
+        AvailabilityProfile p;
+        std::multimap<double, uint32_t> ref;
+        const uint64_t horizon = below(g, 4, 2000);     // small ⇒ many equal times
+        for (int i = 0; i < 5000; ++i, ++check::step) {
+            uint64_t op = below(g, 0, 9);
+            if (op < 4 || ref.empty()) {
+                double   t = double(below(g, 0, horizon)) / 2;
+                uint32_t q = uint32_t(below(g, 0, 16));
+                p.add(t, q);
+                if (q) ref.emplace(t, q);
+            } else if (op < 7) {
+                auto it = std::next(ref.begin(), long(below(g, 0, ref.size() - 1)));
+                p.remove(it->first, it->second);
+                ref.erase(it);
+            } else {
+                double   now  = double(below(g, 0, horizon)) / 2;
+                uint32_t free = uint32_t(below(g, 0, 8));
+                uint32_t need = uint32_t(below(g, 0, 12 * ref.size() + 8));
+                CHECK(p.earliest(now, free, need) == naive_earliest(ref, now, free, need));
+            }
+            double t = double(below(g, 0, horizon + 2)) / 2 - 1;
+            CHECK(p.released_by(t) == naive_released_by(ref, t));
+            CHECK(p.total() == naive_released_by(ref, horizon));
+            CHECK(p.empty() == ref.empty());
+        }
+        p.clear();
+        CHECK(p.empty() && p.total() == 0);
+    }
+    return check::pass("availability_profile");
+}
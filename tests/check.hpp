@@ -0,0 +1,51 @@
+/**************************************************************
+ *  check.hpp  —  the little the randomized tests share
+ *
+ *  Each test drives one structure with random operations and
+ *  compares it, after every step, with a naive reference.  The
+ *  seed is fixed so that a run is reproducible; a first argument
+ *  overrides it.  CHECK() reports a mismatch with the seed and
+ *  the step; a test stops at its first mismatch and exits 1.
+ *************************************************************/
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+namespace check {
+
+inline uint64_t seed = 1;
+inline uint64_t step = 0;             // operation being checked
+
+inline std::mt19937_64 rng_from(int argc, char** argv)
+{
+    if (argc > 1) seed = std::strtoull(argv[1], nullptr, 10);
+    return std::mt19937_64(seed);
+}
+
+[[noreturn]] inline void fail(const char* file, int line, const char* what)
+{
+    std::fprintf(stderr, "%s:%d: %s  (seed %llu, step %llu)\n", file, line, what,
+                 (unsigned long long)seed, (unsigned long long)step);
+    std::exit(1);
+}
+
+inline int pass(const char* name)
+{
+    std::printf("%s: ok, %llu steps, seed %llu\n", name, (unsigned long long)step,
+                (unsigned long long)seed);
+    return 0;
+}
+
+/* uniform integer in [lo, hi] */
+template <class Rng>
+inline uint64_t below(Rng& g, uint64_t lo, uint64_t hi)
+{
+    return std::uniform_int_distribution<uint64_t>(lo, hi)(g);
+}
+
+} // namespace check
+
+#define CHECK(cond) do { if (!(cond)) check::fail(__FILE__, __LINE__, #cond); } while (0)
@@ -0,0 +1,197 @@
+/**************************************************************
+ *  batprotocol.hpp  —  the part of batprotocol-cpp the plug-ins
+ *                      use, for tests/schedules.cpp to drive
+ *                      them in-process
+ *
+ *  Messages are not serialized: the driver hands a plug-in the
+ *  address of a fb::Message it built, and reads the Decisions
+ *  the MessageBuilder collected back through the same pointer.
+ *  Only what the EASY plug-ins call is here.
+ *************************************************************/
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace batprotocol {
+
+struct FStr {
+    std::string s;
+    std::string str()   const { return s; }
+    const char* c_str() const { return s.c_str(); }
+    size_t      size()  const { return s.size(); }
+};
+
+namespace fb {
+
+struct Job {
+    uint32_t res;
+    double   wt;
+    FStr     prof;
+    uint32_t    resource_request() const { return res; }
+    double      walltime()         const { return wt; }
+    const FStr* profile_id()       const { return &prof; }
+};
+
+enum Event {
+    Event_NONE, Event_BatsimHelloEvent, Event_SimulationBeginsEvent, Event_JobSubmittedEvent,
+    Event_JobCompletedEvent, Event_RequestedCallEvent, Event_JobsKilledEvent,
+    Event_AllStaticJobsHaveBeenSubmittedEvent, Event_SimulationEndsEvent
+};
+
+inline const char* const* EnumNamesEvent()
+{
+    static const char* const names[] = {
+        "NONE", "BatsimHelloEvent", "SimulationBeginsEvent", "JobSubmittedEvent",
+        "JobCompletedEvent", "RequestedCallEvent", "JobsKilledEvent",
+        "AllStaticJobsHaveBeenSubmittedEvent", "SimulationEndsEvent"
+    };
+    return names;
+}
+
+struct SimulationBeginsEvent {
+    uint32_t n;
+    uint32_t computation_host_number() const { return n; }
+};
+
+struct JobSubmittedEvent {
+    FStr id;
+    Job  j;
+    const FStr* job_id() const { return &id; }
+    const Job*  job()    const { return &j; }
+};
+
+struct JobCompletedEvent {
+    FStr id;
+    const FStr* job_id() const { return &id; }
+};
+
+struct RequestedCallEvent {
+    FStr id;
+    const FStr* call_me_later_id() const { return &id; }
+};
+
+struct StrVec {
+    std::vector<const FStr*> v;
+    size_t size() const { return v.size(); }
+    auto begin() const { return v.begin(); }
+    auto end()   const { return v.end(); }
+    const FStr* operator[](size_t i) const { return v[i]; }
+    const FStr* Get(size_t i)        const { return v[i]; }
+};
+
+struct JobsKilledEvent {
+    StrVec ids;
+    const StrVec* job_ids() const { return &ids; }
+};
+
+struct EventHolder {
+    Event                 type = Event_NONE;
+    SimulationBeginsEvent sb{};
+    JobSubmittedEvent     js;
+    JobCompletedEvent     jc;
+    RequestedCallEvent    rc;
+    JobsKilledEvent       jk;
+
+    Event event_type() const { return type; }
+    const SimulationBeginsEvent* event_as_SimulationBeginsEvent() const { return &sb; }
+    const JobSubmittedEvent*     event_as_JobSubmittedEvent()     const { return &js; }
+    const JobCompletedEvent*     event_as_JobCompletedEvent()     const { return &jc; }
+    const RequestedCallEvent*    event_as_RequestedCallEvent()    const { return &rc; }
+    const JobsKilledEvent*       event_as_JobsKilledEvent()       const { return &jk; }
+};
+
+struct EvVec {
+    std::vector<const EventHolder*> v;
+    size_t size() const { return v.size(); }
+    auto begin() const { return v.begin(); }
+    auto end()   const { return v.end(); }
+    const EventHolder* operator[](size_t i) const { return v[i]; }
+};
+
+struct Message {
+    double t;
+    EvVec  ev;
+    double       now()    const { return t; }
+    const EvVec* events() const { return &ev; }
+};
+
+} // namespace fb
+
+struct TemporalTrigger {
+    double t;
+    static std::shared_ptr<TemporalTrigger> make_one_shot(double t)
+    {
+        auto p = std::make_shared<TemporalTrigger>();
+        p->t = t;
+        return p;
+    }
+};
+
+/* a job to register */
+struct Job {
+    uint32_t    res = 0;
+    double      wt  = -1;
+    std::string prof;
+    static std::shared_ptr<Job> make() { return std::make_shared<Job>(); }
+    void set_resource_number(uint32_t n)    { res = n; }
+    void set_walltime(double w)             { wt = w; }
+    void set_profile(const std::string& p)  { prof = p; }
+};
+
+struct EDCHelloOptions {
+    bool dynamic = false, reuse = false;
+    static std::shared_ptr<EDCHelloOptions> make() { return std::make_shared<EDCHelloOptions>(); }
+    void request_dynamic_registration() { dynamic = true; }
+    void request_profile_reuse()        { reuse = true; }
+};
+
+/* what a plug-in decided during one call */
+struct Decisions {
+    std::vector<std::pair<std::string, std::string>> execs;     // (job, hosts)
+    std::vector<std::string>                         rejects;
+    std::vector<std::pair<std::string, double>>      calls;     // (id, instant)
+    std::vector<std::string>                         kills;
+    std::vector<std::pair<std::string, Job>>         registers; // (job, what)
+    bool dynamic_registration = false;                          // asked for in the hello
+    bool registration_finished = false;
+};
+
+class MessageBuilder {
+public:
+    explicit MessageBuilder(bool) {}
+    void clear(double) { d = Decisions(); }
+    void add_edc_hello(const std::string&, const std::string&,
+                       const std::shared_ptr<EDCHelloOptions>& o = nullptr)
+    {
+        d.dynamic_registration = o && o->dynamic && o->reuse;
+    }
+    void add_reject_job(const std::string& id) { d.rejects.push_back(id); }
+    void add_execute_job(const std::string& id, const std::string& hosts) { d.execs.emplace_back(id, hosts); }
+    void add_call_me_later(const std::string& id, const std::shared_ptr<TemporalTrigger>& w)
+    {
+        d.calls.emplace_back(id, w->t);
+    }
+    void add_kill_jobs(const std::vector<std::string>& ids) { d.kills.insert(d.kills.end(), ids.begin(), ids.end()); }
+    void add_register_job(const std::string& id, const std::shared_ptr<Job>& j) { d.registers.emplace_back(id, *j); }
+    void add_finish_registration() { d.registration_finished = true; }
+    void finish_message(double) {}
+
+    Decisions d;
+};
+
+inline const fb::Message* deserialize_message(MessageBuilder&, bool, const uint8_t* buf)
+{
+    return reinterpret_cast<const fb::Message*>(buf);
+}
+
+inline void serialize_message(MessageBuilder& mb, bool, const uint8_t** buf, uint32_t* size)
+{
+    *buf  = reinterpret_cast<const uint8_t*>(&mb.d);
+    *size = sizeof(Decisions);
+}
+
+} // namespace batprotocol
@@ -0,0 +1,40 @@
+/**************************************************************
+ *  intervalset.hpp  —  the part of intervalset the plug-ins
+ *                      use, for tests/schedules.cpp
+ *************************************************************/
+#pragma once
+
+#include <cstdint>
+#include <set>
+#include <string>
+
+class IntervalSet {
+public:
+    struct ClosedInterval {
+        uint32_t a, b;
+        ClosedInterval(uint32_t a, uint32_t b) : a(a), b(b) {}
+    };
+
+    IntervalSet() {}
+    IntervalSet(ClosedInterval c) { insert(c); }
+
+    void insert(ClosedInterval c) { for (uint32_t i = c.a; i <= c.b; ++i) s.insert(i); }
+
+    /* "0-3,8,10-12" */
+    std::string to_string_hyphen(const std::string& sep = ",", const std::string& join = "-") const
+    {
+        std::string out;
+        auto it = s.begin();
+        while (it != s.end()) {
+            uint32_t a = *it, b = a;
+            for (++it; it != s.end() && *it == b + 1; ++it) b = *it;
+            if (!out.empty()) out += sep;
+            out += std::to_string(a);
+            if (b != a) out += join + std::to_string(b);
+        }
+        return out;
+    }
+
+private:
+    std::set<uint32_t> s;
+};
@@ -0,0 +1,88 @@
+/**************************************************************
+ *  host_pool.cpp  —  HostPool against a std::set of free hosts
+ *
+ *  Pools of 1 to ~5000 hosts, so that allocations cross 64-bit
+ *  words and the summary spans several words.  claim() must take
+ *  the lowest free hosts, as walking the set from begin(), in
+ *  sorted, maximal intervals; release() of any live allocation
+ *  must give them back.  to_string() is compared with the
+ *  IntervalSet form "0-3,8,10-12" built from the set.
+ *
+ *      ./test_host_pool [seed]
+ *************************************************************/
+#include <cstdint>
+#include <iterator>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "check.hpp"
+#include "host_pool.hpp"
+
+/* sorted hosts as "a-b,c" with maximal runs */
+static std::string naive_string(const std::vector<uint32_t>& hosts)
+{
+    std::string s;
+    for (size_t i = 0; i < hosts.size(); ) {
+        size_t j = i;
+        while (j + 1 < hosts.size() && hosts[j + 1] == hosts[j] + 1) ++j;
+        if (!s.empty()) s += ',';
+        s += std::to_string(hosts[i]);
+        if (j != i) s += '-' + std::to_string(hosts[j]);
+        i = j + 1;
+    }
+    return s;
+}
+
+int main(int argc, char** argv)
+{
+    auto g = check::rng_from(argc, argv);
+    using check::below;
+
+    HostPool    pool;
+    HostAlloc   a;
+    std::string str;
+    for (int round = 0; round < 60; ++round) {
+        const uint32_t n = uint32_t(below(g, 0, 3) == 0 ? below(g, 4000, 5000) : below(g, 1, 300));
+        pool.reset(n);
+        std::set<uint32_t> free;
+        for (uint32_t h = 0; h < n; ++h) free.insert(h);
+        std::vector<std::vector<uint32_t>> live;      // hosts of each allocation held
+
+        for (int i = 0; i < 400; ++i, ++check::step) {
+            CHECK(pool.size() == n);
+            CHECK(pool.free_count() == free.size());
+            if (below(g, 0, 1) == 0 && !free.empty()) {
+                uint32_t q = uint32_t(below(g, 1, below(g, 0, 4) == 0 ? free.size()
+                                                                      : std::min<size_t>(free.size(), 70)));
+                pool.claim(q, a);
+                std::vector<uint32_t> want(free.begin(), std::next(free.begin(), q));
+                for (uint32_t h : want) free.erase(h);
+
+                std::vector<uint32_t> got;
+                for (size_t k = 0; k < a.size(); ++k) {
+                    CHECK(a[k].first <= a[k].last);
+                    if (k) CHECK(a[k - 1].last + 1 < a[k].first);   // sorted, maximal
+                    for (uint32_t h = a[k].first; h <= a[k].last; ++h) got.push_back(h);
+                }
+                CHECK(got == want);
+                CHECK(HostPool::count(a) == q);
+                HostPool::to_string(a, str);
+                CHECK(str == naive_string(want));
+                live.push_back(want);
+            } else if (!live.empty()) {
+                size_t k = below(g, 0, live.size() - 1);
+                /* release() takes intervals: rebuild them from the hosts */
+                HostAlloc back;
+                for (uint32_t h : live[k]) {
+                    if (!back.empty() && back.back().last + 1 == h) back.back().last = h;
+                    else back.push_back(HostRange{h, h});
+                }
+                pool.release(back);
+                free.insert(live[k].begin(), live[k].end());
+                live.erase(live.begin() + long(k));
+            }
+        }
+    }
+    return check::pass("host_pool");
+}
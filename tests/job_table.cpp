@@ -0,0 +1,105 @@
+/**************************************************************
+ *  job_table.cpp  —  JobTable against a map of the jobs alive
+ *
+ *  Jobs are interned and retired at random, up to a few thousand
+ *  at once.  Every live job must be found by its id with its own
+ *  record and running state, at an address that does not move;
+ *  every retired handle must read as dead even once its slot
+ *  serves another job; and for_each() must visit exactly the
+ *  live jobs, in slot order.  The records come from slabs,
+ *  which must have grown by several chunks.
+ *
+ *      ./test_job_table [seed]
+ *************************************************************/
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "check.hpp"
+#include "job_table.hpp"
+
+namespace {
+
+struct Record {
+    uint64_t seq    = 0;
+    double   submit = -1;
+};
+
+struct Live {
+    JobHandle h;
+    uint64_t  seq;
+    Record*   rec;               // must not move while the job lives
+};
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    auto g = check::rng_from(argc, argv);
+    using check::below;
+
+    JobTable<Record> jobs;
+    std::map<std::string, Live> ref;
+    std::vector<JobHandle> dead;
+    uint64_t seq = 0;
+    for (int i = 0; i < 60000; ++i, ++check::step) {
+        const size_t target = (i / 10000) % 2 ? 200 : 3000;   // grow, shrink, grow again
+        if (ref.empty() || (ref.size() < target && below(g, 0, 2) != 0)) {
+            std::string id = "w" + std::to_string(below(g, 0, 3)) + "!" + std::to_string(seq);
+            JobHandle h = jobs.intern(id);
+            CHECK(jobs.alive(h));
+            CHECK(jobs.record(h).seq == 0 && jobs.record(h).submit == -1);   // fresh record
+            CHECK(!jobs.running(h).active && jobs.running(h).hosts.empty());
+            jobs.record(h).seq    = seq;
+            jobs.record(h).submit = double(seq) / 2;
+            if (below(g, 0, 1)) {
+                jobs.running(h).active   = true;
+                jobs.running(h).nb_hosts = uint32_t(seq % 5 + 1);
+                jobs.running(h).hosts.push_back(HostRange{0, uint32_t(seq % 5)});
+            }
+            ref[id] = Live{h, seq, &jobs.record(h)};
+            ++seq;
+        } else {
+            auto it = ref.begin();
+            std::advance(it, long(below(g, 0, std::min<size_t>(ref.size() - 1, 50))));
+            jobs.retire(it->second.h);
+            CHECK(!jobs.alive(it->second.h));
+            CHECK(!jobs.lookup(it->first).valid());
+            jobs.retire(it->second.h);                                    // twice: no effect
+            dead.push_back(it->second.h);
+            ref.erase(it);
+        }
+
+        CHECK(jobs.live() == ref.size());
+        for (int k = 0; k < 3 && !ref.empty(); ++k) {
+            auto it = ref.begin();
+            std::advance(it, long(below(g, 0, std::min<size_t>(ref.size() - 1, 200))));
+            const Live& l = it->second;
+            JobHandle h = jobs.lookup(it->first);
+            CHECK(h.valid() && h.idx == l.h.idx && h.gen == l.h.gen && jobs.alive(h));
+            CHECK(jobs.id(h) == it->first);
+            CHECK(&jobs.record(h) == l.rec && l.rec->seq == l.seq && l.rec->submit == double(l.seq) / 2);
+            const auto& run = jobs.running(h);
+            CHECK(!run.active || (run.nb_hosts == l.seq % 5 + 1 && HostPool::count(run.hosts) == run.nb_hosts));
+        }
+        if (!dead.empty()) CHECK(!jobs.alive(dead[below(g, 0, dead.size() - 1)]));
+
+        if (i % 997 == 0) {
+            std::vector<uint32_t> seen;
+            jobs.for_each([&](JobHandle h) {
+                CHECK(jobs.alive(h));
+                CHECK(ref.count(jobs.id(h)) && ref[jobs.id(h)].h.idx == h.idx);
+                seen.push_back(h.idx);
+            });
+            CHECK(seen.size() == ref.size());
+            CHECK(std::is_sorted(seen.begin(), seen.end()));
+        }
+    }
+    CHECK(jobs.stats().peak >= 3000 && jobs.stats().chunks >= 3);   // pooled records
+    jobs.clear();
+    CHECK(jobs.live() == 0);
+    for (const auto& [id, l] : ref) CHECK(!jobs.lookup(id).valid());
+    return check::pass("job_table");
+}
@@ -0,0 +1,268 @@
+/**************************************************************
+ *  key_program.cpp  —  KeyProgram against keys written in C++
+ *                      and against a tree evaluator
+ *
+ *  Hand-written cases pin the grammar: precedence, right-
+ *  associative '^', unary minus, functions, blanks, numbers,
+ *  ';'-separated keys and the errors.  Then random expression
+ *  trees are printed fully parenthesised, compiled, and run
+ *  over queues whose length crosses BLOCK, plain and with the
+ *  statics hoisted; every key must be bit-identical to a
+ *  recursive evaluation of the tree with the same operations,
+ *  NaN read as +inf.
+ *
+ *      ./test_key_program [seed]
+ *************************************************************/
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "check.hpp"
+#include "key_program.hpp"
+#include "policies.hpp"
+
+namespace {
+
+struct Queue {
+    std::vector<uint32_t> hosts;
+    std::vector<double>   wall, submit;
+    double                now = 0;
+
+    size_t size() const { return hosts.size(); }
+};
+
+Queue make_queue(std::mt19937_64& g, size_t n)
+{
+    using check::below;
+    Queue q;
+    q.now = double(below(g, 0, 200000)) + 0.25;
+    for (size_t i = 0; i < n; ++i) {
+        q.hosts.push_back(uint32_t(below(g, 1, 128)));
+        q.wall.push_back(double(below(g, 1, 86400)));
+        q.submit.push_back(q.now - double(below(g, 0, 100000)));
+    }
+    return q;
+}
+
+double nan_as_inf(double k) { return k == k ? k : HUGE_VAL; }
+
+/* keys of every job of q from the program, plain or hoisted */
+std::vector<double> run(const KeyProgram& k, const Queue& q)
+{
+    std::vector<double> out(q.size()), st(q.size() * k.statics());
+    const size_t stride = k.statics();
+    if (stride) k.eval_statics(q.hosts.data(), q.wall.data(), q.submit.data(), q.size(), st.data(), stride);
+    k.eval(q.hosts.data(), q.wall.data(), q.submit.data(), q.size(), q.now, out.data(),
+           stride ? st.data() : nullptr, stride);
+    return out;
+}
+
+bool same(double a, double b) { return a == b || (a != a && b != b); }
+
+/* ---- hand-written keys ---------------------------------------- */
+using Fn = std::function<double(double h, double w, double s, double now)>;
+
+struct Case { const char* src; Fn fn; bool timed; };
+
+void hand_written(std::mt19937_64& g)
+{
+    const Case cases[] = {
+        {"nb_hosts*walltime", [](double h, double w, double, double) { return h * w; }, false},
+        {"1+2*3-nb_hosts/2", [](double h, double, double, double) { return 7 - h / 2; }, false},
+        {"2^3^2 + walltime", [](double, double w, double, double) { return 512 + w; }, false},
+        {"-2^2*nb_hosts", [](double h, double, double, double) { return -4 * h; }, false},
+        {"walltime^-1", [](double, double w, double, double) {
+             volatile double e = -1;          // pow(w, -1.0) would be folded into 1/w
+             return std::pow(w, e);
+         }, false},
+        {"walltime - -submit_time", [](double, double w, double s, double) { return w - -s; }, false},
+        {"nb_hosts - walltime - submit_time", [](double h, double w, double s, double) { return h - w - s; }, false},
+        {"nb_hosts / walltime / 2", [](double h, double w, double, double) { return h / w / 2; }, false},
+        {"+nb_hosts", [](double h, double, double, double) { return h; }, false},
+        {"1e3*nb_hosts + .5", [](double h, double, double, double) { return 1e3 * h + .5; }, false},
+        {" log10 ( walltime ) * nb_hosts+870*log10(submit_age) ",
+         [](double h, double w, double s, double now) { return std::log10(w) * h + 870 * std::log10(now - s); }, true},
+        {"sqrt(abs(now - submit_time*2)) / exp(1) + ln(nb_hosts) - log2(walltime)",
+         [](double h, double w, double s, double now) {
+             return std::sqrt(std::fabs(now - s * 2)) / std::exp(1.0) + std::log(h) - std::log2(w);
+         }, true},
+        {"-((submit_age+walltime)/walltime)",
+         [](double, double w, double s, double now) { return -((now - s + w) / w); }, true},
+        {"0/0 + nb_hosts", [](double, double, double, double) { return HUGE_VAL; }, false},
+        {"ln(-walltime)", [](double, double, double, double) { return HUGE_VAL; }, false},
+        {"(((now)))", [](double, double, double, double now) { return now; }, true},
+    };
+    Queue q = make_queue(g, 700);
+    for (const Case& c : cases) {
+        for (bool hoist : {false, true}) {
+            ++check::step;
+            KeyProgram k;
+            std::string err;
+            CHECK(k.compile(c.src, err, hoist) && err.empty());
+            CHECK(k.uses_now() == c.timed);
+            CHECK(k.source() == c.src);
+            std::vector<double> got = run(k, q);
+            for (size_t i = 0; i < q.size(); ++i)
+                CHECK(got[i] == nan_as_inf(c.fn(q.hosts[i], q.wall[i], q.submit[i], q.now)));
+        }
+    }
+
+    /* the built-in orders spelled as expressions give their keys */
+    struct Job { uint32_t nb_hosts; double walltime, submit_time; };
+    for (const auto& [name, pol] : STR2POL) {
+        ++check::step;
+        KeyProgram k;
+        std::string err;
+        CHECK(k.compile(policy_expression(pol), err));
+        std::vector<double> got = run(k, q);
+        for (size_t i = 0; i < q.size(); ++i) {
+            Job j{q.hosts[i], q.wall[i], q.submit[i]};
+            CHECK(got[i] == key_for(&j, q.now, pol));
+        }
+    }
+
+    /* tie-breaking keys */
+    std::vector<KeyProgram> keys;
+    std::string err;
+    CHECK(compile_keys("nb_hosts;-walltime;submit_age", keys, err, true));
+    CHECK(keys.size() == 3 && keys[0].source() == "nb_hosts" && keys[2].uses_now());
+    CHECK(run(keys[1], q)[5] == -q.wall[5]);
+
+    /* errors name what is wrong */
+    const char* bad[] = {"", "   ", "1+", "(1", "1)", "foo", "log10 1", "1 2", "nb_hosts*(walltime",
+                         "sqrt()", "submit-age", "2^", "*3", "exp(1", "a;"};
+    for (const char* src : bad) {
+        ++check::step;
+        KeyProgram k;
+        CHECK(!k.compile(src, err) && !err.empty());
+    }
+    CHECK(!compile_keys("nb_hosts;walltme", keys, err));
+    CHECK(err == "'walltme': unknown name 'walltme'");
+    CHECK(!compile_keys("nb_hosts;", keys, err));
+}
+
+/* ---- random trees --------------------------------------------- */
+struct Tree {
+    enum Kind { NUM, VAR, UN, BIN } kind;
+    double c = 0;
+    int    var = 0;                 // nb_hosts walltime submit_time submit_age now
+    int    op  = 0;                 // UN: - log10 log2 ln sqrt abs exp; BIN: + - * / ^
+    std::unique_ptr<Tree> a, b;
+};
+
+const char* const VARS[] = {"nb_hosts", "walltime", "submit_time", "submit_age", "now"};
+const char* const FUNS[] = {"-", "log10", "log2", "ln", "sqrt", "abs", "exp"};
+const char        BINS[] = {'+', '-', '*', '/', '^'};
+
+std::unique_ptr<Tree> grow(std::mt19937_64& g, int depth)
+{
+    using check::below;
+    auto t = std::make_unique<Tree>();
+    uint64_t r = below(g, 0, 9);
+    if (depth == 0 || r < 3) {
+        if (below(g, 0, 2) == 0) {
+            t->kind = Tree::NUM;
+            t->c = below(g, 0, 1) ? double(below(g, 0, 20)) : double(below(g, 1, 1 << 20)) / 1024;
+        } else {
+            t->kind = Tree::VAR;
+            t->var = int(below(g, 0, 4));
+        }
+    } else if (r < 5) {
+        t->kind = Tree::UN;
+        t->op = int(below(g, 0, 6));
+        t->a = grow(g, depth - 1);
+    } else {
+        t->kind = Tree::BIN;
+        t->op = below(g, 0, 7) == 0 ? 4 : int(below(g, 0, 3));    // few powers
+        t->a = grow(g, depth - 1);
+        t->b = grow(g, depth - 1);
+    }
+    return t;
+}
+
+std::string print(const Tree& t, std::mt19937_64& g)
+{
+    std::string sp = check::below(g, 0, 3) == 0 ? " " : "";
+    char num[32];
+    switch (t.kind) {
+        case Tree::NUM: std::snprintf(num, sizeof num, "%.17g", t.c); return num;
+        case Tree::VAR: return VARS[t.var];
+        case Tree::UN:  return std::string(FUNS[t.op]) + sp + "(" + print(*t.a, g) + ")";
+        case Tree::BIN: return "(" + print(*t.a, g) + ")" + sp + BINS[t.op] + sp + "(" + print(*t.b, g) + ")";
+    }
+    return "";
+}
+
+double eval(const Tree& t, double h, double w, double s, double now)
+{
+    switch (t.kind) {
+        case Tree::NUM: return t.c;
+        case Tree::VAR: {
+            const double v[] = {h, w, s, now - s, now};
+            return v[t.var];
+        }
+        case Tree::UN: {
+            double x = eval(*t.a, h, w, s, now);
+            switch (t.op) {
+                case 0: return -x;
+                case 1: return std::log10(x);
+                case 2: return std::log2(x);
+                case 3: return std::log(x);
+                case 4: return std::sqrt(x);
+                case 5: return std::fabs(x);
+                default: return std::exp(x);
+            }
+        }
+        case Tree::BIN: {
+            double x = eval(*t.a, h, w, s, now), y = eval(*t.b, h, w, s, now);
+            switch (t.op) {
+                case 0: return x + y;
+                case 1: return x - y;
+                case 2: return x * y;
+                case 3: return x / y;
+                default: return std::pow(x, y);
+            }
+        }
+    }
+    return 0;
+}
+
+bool timed(const Tree& t)
+{
+    if (t.kind == Tree::VAR) return t.var >= 3;
+    return (t.a && timed(*t.a)) || (t.b && timed(*t.b));
+}
+
+void random_trees(std::mt19937_64& g)
+{
+    using check::below;
+    for (int i = 0; i < 3000; ++i, ++check::step) {
+        auto t = grow(g, int(below(g, 1, 7)));
+        std::string src = print(*t, g);
+        Queue q = make_queue(g, below(g, 0, 3) == 0 ? below(g, 0, 5) : below(g, 1, 3 * KeyProgram::BLOCK));
+        for (bool hoist : {false, true}) {
+            KeyProgram k;
+            std::string err;
+            CHECK(k.compile(src, err, hoist));
+            CHECK(k.uses_now() == timed(*t));
+            if (!hoist || !k.uses_now()) CHECK(k.statics() == 0);
+            std::vector<double> got = run(k, q);
+            for (size_t j = 0; j < q.size(); ++j)
+                CHECK(same(got[j], nan_as_inf(eval(*t, q.hosts[j], q.wall[j], q.submit[j], q.now))));
+        }
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    auto g = check::rng_from(argc, argv);
+    hand_written(g);
+    random_trees(g);
+    return check::pass("key_program");
+}
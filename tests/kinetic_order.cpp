@@ -0,0 +1,119 @@
+/**************************************************************
+ *  kinetic_order.cpp  —  KineticOrder and KineticTournament
+ *                        against a sort at every instant
+ *
+ *  EXP keys (policies.hpp ExpLine) of jobs with few distinct
+ *  submit times and walltimes, so that keys cross often and tie
+ *  for good.  Time moves forward by random steps, jobs come and
+ *  go and move between two orders, as the engines do with their
+ *  aged and young queues; after each step the whole order, and
+ *  the tournament's head, must be those of a sort by (key, seq).
+ *  As in the engines, an order is advanced before jobs go in.
+ *
+ *      ./test_kinetic_order [seed]
+ *************************************************************/
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#include "check.hpp"
+#include "kinetic_order.hpp"
+#include "policies.hpp"
+
+namespace {
+
+struct Job {
+    uint32_t nb_hosts;
+    double   walltime;
+    double   submit_time;
+    uint64_t seq;
+};
+
+using Line = ExpLine<Job>;
+
+/* jobs of `in` sorted as the orders must hold them at t */
+std::vector<Job*> sorted(const std::vector<Job*>& in, double t)
+{
+    std::vector<Job*> v = in;
+    std::sort(v.begin(), v.end(), [t](const Job* a, const Job* b) {
+        double ka = Line::key(a, t), kb = Line::key(b, t);
+        return ka < kb || (ka == kb && a->seq < b->seq);
+    });
+    return v;
+}
+
+template <class Order>
+void check_order(const Order& o, const std::vector<Job*>& members, double t)
+{
+    std::vector<Job*> want = sorted(members, t);
+    CHECK(o.size() == want.size());
+    CHECK(o.empty() == want.empty());
+    size_t i = 0;
+    for (const auto& slot : o) { CHECK(i < want.size() && slot.job == want[i]); ++i; }
+    CHECK(i == want.size());
+    CHECK(o.front() == (want.empty() ? nullptr : want.front()));
+    CHECK(o.back()  == (want.empty() ? nullptr : want.back()));
+}
+
+template <class Tour>
+void check_head(const Tour& o, const std::vector<Job*>& members, double t)
+{
+    std::vector<Job*> want = sorted(members, t);
+    CHECK(o.size() == want.size());
+    CHECK(o.front() == (want.empty() ? nullptr : want.front()));
+}
+
+void erase_from(std::vector<Job*>& v, Job* j)
+{
+    v.erase(std::find(v.begin(), v.end(), j));
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    auto g = check::rng_from(argc, argv);
+    using check::below;
+
+    for (int round = 0; round < 40; ++round) {
+        std::deque<Job> jobs;
+        KineticOrder<Job, Line>      ord[2];
+        KineticTournament<Job, Line> tour[2];
+        std::vector<Job*>            in[2];       // members of ord[k] and tour[k]
+        double   now = 0;
+        uint64_t seq = 0;
+        const uint64_t walls = below(g, 1, 12);
+        for (int k = 0; k < 2; ++k) { ord[k].advance(now); tour[k].advance(now); }
+
+        for (int i = 0; i < 600; ++i, ++check::step) {
+            uint64_t op = below(g, 0, 9);
+            if (op < 4 || (in[0].empty() && in[1].empty())) {
+                jobs.push_back(Job{1, double(60 * below(g, 1, walls)),
+                                   now - double(below(g, 0, 3)) * 600, seq++});
+                Job* j = &jobs.back();
+                int  k = int(below(g, 0, 1));
+                ord[k].insert(j); tour[k].insert(j); in[k].push_back(j);
+            } else if (op < 6) {
+                int k = in[0].empty() ? 1 : in[1].empty() ? 0 : int(below(g, 0, 1));
+                Job* j = in[k][below(g, 0, in[k].size() - 1)];
+                ord[k].erase(j); tour[k].erase(j); erase_from(in[k], j);
+            } else if (op < 8) {
+                int k = in[0].empty() ? 1 : in[1].empty() ? 0 : int(below(g, 0, 1));
+                Job* j = in[k][below(g, 0, in[k].size() - 1)];
+                ord[k].move_to(j, ord[1 - k]); tour[k].move_to(j, tour[1 - k]);
+                erase_from(in[k], j); in[1 - k].push_back(j);
+            } else {
+                now += below(g, 0, 3) == 0 ? double(below(g, 0, 36000)) : double(below(g, 0, 120));
+                for (int k = 0; k < 2; ++k) { ord[k].advance(now); tour[k].advance(now); }
+            }
+            for (int k = 0; k < 2; ++k) {
+                check_order(ord[k], in[k], now);
+                check_head(tour[k], in[k], now);
+            }
+        }
+        for (int k = 0; k < 2; ++k) { ord[k].clear(); tour[k].clear(); }
+        CHECK(ord[0].empty() && tour[0].empty() && tour[0].front() == nullptr);
+    }
+    return check::pass("kinetic_order");
+}
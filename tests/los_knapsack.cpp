@@ -0,0 +1,74 @@
+/**************************************************************
+ *  los_knapsack.cpp  —  LosKnapsack against every subset
+ *
+ *  Up to 12 candidates, some running past the shadow time.  The
+ *  reference tries all subsets that fit in the free hosts, with
+ *  the past ones also in the extra hosts, and keeps the one using
+ *  the most hosts; ties go to the subset that takes the earliest
+ *  candidate where two differ, as select() promises.  With a unit
+ *  u > 1 the sizes are rounded up, and the free and extra hosts
+ *  down, to blocks of u, but the subsets are still compared by
+ *  hosts.  The same LosKnapsack is reused across calls, as the
+ *  engine does.
+ *
+ *      ./test_los_knapsack [seed]
+ *************************************************************/
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "check.hpp"
+#include "los_knapsack.hpp"
+
+static std::vector<uint32_t> naive_select(const std::vector<LosKnapsack::Item>& items,
+                                          uint32_t free, uint32_t extra, uint32_t unit)
+{
+    const uint32_t n = uint32_t(items.size());
+    uint64_t best = 0;
+    uint32_t best_mask = 0;
+    bool     found = false;
+    for (uint32_t m = 0; m < (1u << n); ++m) {
+        uint64_t f = 0, e = 0, used = 0;
+        for (uint32_t i = 0; i < n; ++i)
+            if (m >> i & 1) {
+                uint32_t blocks = (items[i].hosts + unit - 1) / unit;
+                f += blocks; used += items[i].hosts;
+                if (items[i].past) e += blocks;
+            }
+        if (f > free / unit || e > std::min(extra, free) / unit) continue;
+        /* on a tie, the first candidate in only one of the two decides */
+        bool better = !found || used > best;
+        if (found && used == best && m != best_mask) {
+            uint32_t first = __builtin_ctz(m ^ best_mask);
+            better = m >> first & 1;
+        }
+        if (better) { best = used; best_mask = m; found = true; }
+    }
+    std::vector<uint32_t> out;
+    for (uint32_t i = 0; i < n; ++i) if (best_mask >> i & 1) out.push_back(i);
+    return out;
+}
+
+int main(int argc, char** argv)
+{
+    auto g = check::rng_from(argc, argv);
+    using check::below;
+
+    LosKnapsack k;
+    for (int i = 0; i < 20000; ++i, ++check::step) {
+        const uint32_t n     = uint32_t(below(g, 0, 12));
+        const uint32_t big   = uint32_t(below(g, 1, 24));
+        const uint32_t free  = uint32_t(below(g, 0, 40));
+        const uint32_t extra = uint32_t(below(g, 0, 45));
+        const uint32_t unit  = below(g, 0, 2) == 0 ? 1 : uint32_t(below(g, 2, 6));
+        std::vector<LosKnapsack::Item> items;
+        for (uint32_t j = 0; j < n; ++j)
+            items.push_back({uint32_t(below(g, 1, big)), below(g, 0, 2) == 0});
+
+        const std::vector<uint32_t>& got = k.select(items, free, extra, unit);
+        CHECK(got == naive_select(items, free, extra, unit));
+        CHECK(LosKnapsack::cells(n, free, extra, unit) ==
+              (n + 1) * (size_t(free / unit) + 1) * (size_t(std::min(extra, free) / unit) + 1));
+    }
+    return check::pass("los_knapsack");
+}
@@ -0,0 +1,159 @@
+/**************************************************************
+ *  reservation_profile.cpp  —  ReservationProfile against the
+ *                              list of range additions
+ *
+ *  The reference keeps every add(t0, t1, d) and sweeps them into
+ *  the step function, equal neighbours merged, to scan.  Random
+ *  additions (running jobs, reservations, early completions
+ *  undoing them) and trims are checked with at(), max_over(),
+ *  fits(), until(), earliest() with and without a budget, and
+ *  size(), which holds only if equal steps are merged back.
+ *
+ *      ./test_reservation_profile [seed]
+ *************************************************************/
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "check.hpp"
+#include "reservation_profile.hpp"
+
+namespace {
+
+const double NEVER = ReservationProfile::NEVER;
+
+struct Naive {
+    struct Range { double t0, t1; int64_t d; };
+
+    double             origin = 0;
+    int64_t            base   = 0;
+    std::vector<Range> ranges;
+
+    /* the step function from origin on, equal neighbours merged: (t, hosts) */
+    std::vector<std::pair<double, int64_t>> steps() const
+    {
+        std::map<double, int64_t> delta;
+        int64_t v = base;
+        for (const Range& r : ranges) {
+            if (r.t0 <= origin) v += r.d; else delta[r.t0] += r.d;
+            if (r.t1 == NEVER) continue;
+            if (r.t1 <= origin) v -= r.d; else delta[r.t1] -= r.d;
+        }
+        std::vector<std::pair<double, int64_t>> out{{origin, v}};
+        for (const auto& [t, d] : delta) {
+            v += d;
+            if (v != out.back().second) out.emplace_back(t, v);
+        }
+        return out;
+    }
+};
+
+using Steps = std::vector<std::pair<double, int64_t>>;
+
+/* index of the step t falls in (t >= the first breakpoint) */
+size_t step_of(const Steps& s, double t)
+{
+    size_t i = 0;
+    while (i + 1 < s.size() && s[i + 1].first <= t) ++i;
+    return i;
+}
+
+int64_t at(const Steps& s, double t)
+{
+    return t < s[0].first ? 0 : s[step_of(s, t)].second;
+}
+
+int64_t max_over(const Steps& s, double t0, double t1)
+{
+    if (!(t0 < t1)) return 0;
+    int64_t m = at(s, t0);
+    for (size_t i = step_of(s, t0) + 1; i < s.size() && s[i].first < t1; ++i)
+        m = std::max(m, s[i].second);
+    return m;
+}
+
+bool fits(const Steps& s, double t, int64_t q, double dur)
+{
+    if (at(s, t) < q) return false;
+    for (size_t i = step_of(s, t) + 1; i < s.size() && s[i].first < t + dur; ++i)
+        if (s[i].second < q) return false;
+    return true;
+}
+
+double until(const Steps& s, double t, int64_t q)
+{
+    if (at(s, t) < q) return t;
+    for (size_t i = step_of(s, t) + 1; i < s.size(); ++i)
+        if (s[i].second < q) return s[i].first;
+    return NEVER;
+}
+
+double earliest(const Steps& s, double from, int64_t q, double dur)
+{
+    if (fits(s, from, q, dur)) return from;
+    for (size_t i = step_of(s, from) + 1; i < s.size(); ++i)
+        if (fits(s, s[i].first, q, dur)) return s[i].first;
+    return NEVER;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    auto g = check::rng_from(argc, argv);
+    using check::below;
+
+    for (int round = 0; round < 20; ++round) {
+        ReservationProfile p;
+        Naive ref;
+        ref.origin = double(below(g, 0, 10));
+        ref.base   = int64_t(below(g, 0, 64));
+        p.reset(ref.origin, ref.base);
+        const uint64_t span = below(g, 8, 400);         // small ⇒ many shared instants
+
+        auto instant = [&](double lo) { return lo + double(below(g, 0, span)) / 2; };
+
+        for (int i = 0; i < 1200; ++i, ++check::step) {
+            uint64_t op = below(g, 0, 15);
+            double   t  = instant(ref.origin);
+            if (op < 5) {
+                double  t1 = below(g, 0, 7) == 0 ? NEVER : instant(t);
+                int64_t d  = int64_t(below(g, 0, 24)) - 16;
+                p.add(t, t1, d);
+                if (d != 0 && t < t1) ref.ranges.push_back({t, t1, d});
+            } else if (op < 7 && !ref.ranges.empty()) {
+                /* an early completion: undo part of an earlier range */
+                size_t k = below(g, 0, ref.ranges.size() - 1);
+                Naive::Range r = ref.ranges[k];
+                double cut = std::max(r.t0, instant(ref.origin));
+                if (cut < r.t1) {
+                    p.add(cut, r.t1, -r.d);
+                    ref.ranges.push_back({cut, r.t1, -r.d});
+                }
+            } else if (op == 7) {
+                double now = ref.origin + double(below(g, 0, span / 8 + 1)) / 2;
+                p.trim(now);
+                ref.origin = std::max(ref.origin, now);
+            } else {
+                int64_t q   = int64_t(below(g, 0, 80)) - 8;
+                double  dur = double(below(g, 0, span)) / 4;
+                Steps   s   = ref.steps();
+                CHECK(p.at(t) == at(s, t));
+                double t1 = instant(t);
+                CHECK(p.max_over(t, t1) == max_over(s, t, t1));
+                CHECK(p.fits(t, q, dur) == fits(s, t, q, dur));
+                CHECK(p.until(t, q) == until(s, t, q));
+                double e = earliest(s, t, q, dur);
+                CHECK(p.earliest(t, q, dur) == e);
+                size_t budget = below(g, 0, 6), left = budget;
+                double b = p.earliest(t, q, dur, &left);
+                CHECK(left <= budget);
+                CHECK(b == e || (b == NEVER && left == 0));
+            }
+            CHECK(p.size() == ref.steps().size());
+        }
+    }
+    return check::pass("reservation_profile");
+}
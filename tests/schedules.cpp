@@ -0,0 +1,803 @@
+/**************************************************************
+ *  schedules.cpp  —  schedule regression: easy_variants against
+ *                    the single-order plug-ins it replaces, and
+ *                    its built-in orders against the same keys
+ *                    spelled as expressions
+ *
+ *  Each plug-in is loaded in a child process and replayed over
+ *  small synthetic workloads (lognormal runtimes, walltimes 1.2
+ *  to 4 times the runtime, a few jobs overrunning theirs) through
+ *  the fake protocol of tests/fake.  The driver plays Batsim: it
+ *  rejects a job started twice, on a busy or missing host or with
+ *  the wrong size, a call-me-later in the past or under an id
+ *  still pending, and a run that leaves jobs unstarted.  Two runs
+ *  must start the same jobs at the same instants on the same
+ *  hosts; the first difference is printed.
+ *
+ *  The modes that change the schedule on purpose are held to
+ *  what they promise instead:
+ *      #cons   with every job running its walltime, each job
+ *              starts at the reservation it got on submission
+ *      #los    at each call, no fewer hosts started than by the
+ *              greedy EASY pass, when all that fit are in one
+ *              selection, also on a 256 times wider machine
+ *      #pred   with every job running its walltime, plain EASY
+ *      #adapt  at each call, the jobs a plain EASY pass starts
+ *              under one of the candidate orders
+ *      #tune   started at its upper bound with waits far below
+ *              it, the fixed threshold
+ *      #kN     #k1 is plain EASY, #k1000 is #cons, a bad N is
+ *              an init error
+ *      #spec   under FCFS, jobs are killed only for a waiting
+ *              head that needs each of them; in any order, each
+ *              killed job is registered again as itself and the
+ *              registration ends
+ *
+ *      ./test_schedules libeasy_variants_fake.so libeasy_P_P.so...
+ *
+ *  P, the order a reference plug-in implements, is read from its
+ *  file name.
+ *************************************************************/
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <random>
+#include <set>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <batprotocol.hpp>
+
+#include "batsim_edc.h"
+#include "policies.hpp"
+
+using namespace batprotocol;
+
+namespace {
+
+struct JobSpec {
+    std::string id;
+    double      submit, walltime, runtime;
+    uint32_t    hosts;
+};
+
+struct Workload {
+    uint32_t             hosts;
+    std::vector<JobSpec> jobs;
+};
+
+/* as the synthetic workloads of the experiments, denser */
+Workload make_workload(uint64_t seed, uint32_t hosts, size_t n)
+{
+    std::mt19937_64 g(seed);
+    std::exponential_distribution<double> gap(1 / 15.0);
+    std::lognormal_distribution<double>   width(0.8, 1.0), length(5.3, 1.0);
+    std::uniform_real_distribution<double> slack(1.2, 4.0);
+    Workload w{hosts, {}};
+    double t = 0;
+    for (size_t i = 0; i < n; ++i) {
+        t += gap(g);
+        uint32_t r   = std::clamp<uint32_t>(uint32_t(width(g)), 1, hosts);
+        double   run = std::max(1.0, std::floor(length(g) * std::pow(r, 0.4)));
+        double   wt  = std::floor(run * slack(g));
+        if (g() % 20 == 0) run = wt + 1 + double(g() % 600);    // killed at its walltime
+        w.jobs.push_back(JobSpec{std::to_string(i + 1), std::round(t), wt, run, r});
+    }
+    return w;
+}
+
+/* the same jobs on a machine k times wider, each k times wider, less a
+   few hosts so that the widths are not all multiples of k             */
+Workload widen(Workload w, uint32_t k)
+{
+    w.hosts *= k;
+    for (size_t i = 0; i < w.jobs.size(); ++i)
+        w.jobs[i].hosts = std::max<uint32_t>(1, w.jobs[i].hosts * k - uint32_t(i % 5));
+    return w;
+}
+
+/* the same jobs, each running exactly its walltime */
+Workload runs_walltime(Workload w)
+{
+    for (JobSpec& j : w.jobs) j.runtime = j.walltime;
+    return w;
+}
+
+/* conservative backfilling when every job runs its walltime: in order of
+   submission, each job takes the earliest instant from its submission on
+   where the jobs placed before it leave it room for its whole walltime  */
+std::vector<double> conservative_starts(const Workload& w)
+{
+    struct Placed { double start, end; uint32_t hosts; };
+    std::vector<Placed> placed;
+    std::vector<double> out;
+    auto used = [&](double t) {
+        uint32_t u = 0;
+        for (const Placed& p : placed) if (p.start <= t && t < p.end) u += p.hosts;
+        return u;
+    };
+    for (const JobSpec& j : w.jobs) {
+        std::vector<double> at{j.submit};
+        for (const Placed& p : placed) if (p.end > j.submit) at.push_back(p.end);
+        std::sort(at.begin(), at.end());
+        double start = at.back();
+        for (double t : at) {
+            bool fits = used(t) + j.hosts <= w.hosts;
+            for (const Placed& p : placed)
+                if (fits && p.start > t && p.start < t + j.walltime)
+                    fits = used(p.start) + j.hosts <= w.hosts;
+            if (fits) { start = t; break; }
+        }
+        placed.push_back(Placed{start, start + j.walltime, j.hosts});
+        out.push_back(start);
+    }
+    return out;
+}
+
+/* "0-2,5" and "0,1,2,5" are the same hosts */
+std::set<uint32_t> parse_hosts(const std::string& s)
+{
+    std::set<uint32_t> r;
+    std::stringstream ss(s);
+    std::string tok;
+    while (std::getline(ss, tok, ',')) {
+        size_t d = tok.find('-');
+        uint32_t a = uint32_t(std::stoul(tok.substr(0, d)));
+        uint32_t b = d == std::string::npos ? a : uint32_t(std::stoul(tok.substr(d + 1)));
+        for (uint32_t h = a; h <= b; ++h) r.insert(h);
+    }
+    return r;
+}
+
+std::string hosts_string(const std::set<uint32_t>& hosts)
+{
+    std::string s;
+    for (auto it = hosts.begin(); it != hosts.end(); ) {
+        uint32_t a = *it, b = a;
+        for (++it; it != hosts.end() && *it == b + 1; ++it) b = *it;
+        if (!s.empty()) s += ',';
+        s += std::to_string(a);
+        if (b != a) s += '-' + std::to_string(b);
+    }
+    return s;
+}
+
+[[noreturn]] void die(const char* fmt, const std::string& a, double t = 0)
+{
+    std::fprintf(stderr, fmt, a.c_str(), t);
+    std::fputc('\n', stderr);
+    std::_Exit(1);
+}
+
+struct Plugin {
+    decltype(&batsim_edc_init)           init;
+    decltype(&batsim_edc_deinit)         deinit;
+    decltype(&batsim_edc_take_decisions) take;
+};
+
+Plugin load(const char* so)
+{
+    void* lib = dlopen(so, RTLD_NOW | RTLD_LOCAL);
+    if (!lib) die("%s", dlerror());
+    Plugin pl{reinterpret_cast<decltype(&batsim_edc_init)>(dlsym(lib, "batsim_edc_init")),
+              reinterpret_cast<decltype(&batsim_edc_deinit)>(dlsym(lib, "batsim_edc_deinit")),
+              reinterpret_cast<decltype(&batsim_edc_take_decisions)>(dlsym(lib, "batsim_edc_take_decisions"))};
+    if (!pl.init || !pl.deinit || !pl.take) die("%s: not an EDC plug-in", so);
+    return pl;
+}
+
+struct JobState {
+    bool submitted = false, running = false, done = false, killed = false;
+    double start = -1;
+    std::set<uint32_t> hosts;
+    std::string id;
+    size_t origin = 0;      // workload job it runs (again, if registered)
+};
+
+/* called at each decision with the jobs as the plug-in saw them and what
+   it decided; dies on what it must not have done                        */
+using CallCheck = std::function<void(double now, const std::vector<JobState>&, const Decisions&)>;
+
+/* a job registered as "<id>#r<n>" runs the one killed as "<id>#r<n-1>",
+   or "<id>" for n = 1; "" if the id is not of that form             */
+std::string rerun_of(const std::string& id)
+{
+    size_t r = id.rfind("#r");
+    if (r == std::string::npos || r + 2 == id.size() ||
+        id.find_first_not_of("0123456789", r + 2) != std::string::npos || id[r + 2] == '0')
+        return "";
+    unsigned long n = std::stoul(id.substr(r + 2));
+    return n == 1 ? id.substr(0, r) : id.substr(0, r) + "#r" + std::to_string(n - 1);
+}
+
+/* replays w against the plug-in with `arg`; one line per job started,
+   "instant id hosts".  Each job runs the profile "p<id>"; a job the
+   plug-in registers (after asking for it in its hello) must run again
+   one it killed, with its hosts, walltime and profile.              */
+std::string replay(const Plugin& pl, const std::string& arg, const Workload& w,
+                   const CallCheck& check = nullptr)
+{
+    std::vector<JobSpec>  jobs = w.jobs;      // and those registered
+    std::vector<JobState> st(w.jobs.size());
+    std::unordered_map<std::string, size_t> index;
+    for (size_t i = 0; i < w.jobs.size(); ++i) {
+        index[w.jobs[i].id] = i;
+        st[i].id = w.jobs[i].id;
+        st[i].origin = i;
+    }
+
+    if (pl.init(reinterpret_cast<const uint8_t*>(arg.data()), uint32_t(arg.size()),
+                BATSIM_EDC_FORMAT_BINARY) != 0)
+        die("%s: init failed", arg);
+
+    enum Kind { COMPLETION, SUBMISSION, CALL };
+    std::multimap<double, std::pair<Kind, std::string>> timeline;   // equal instants: FIFO
+    for (const JobSpec& j : w.jobs) timeline.emplace(j.submit, std::make_pair(SUBMISSION, j.id));
+    std::vector<bool>        busy(w.hosts, false);
+    std::set<std::string>    pending_calls;
+    std::vector<std::string> killed;
+    std::string              out;
+    double now = 0;
+    bool   first = true;
+    size_t unsubmitted = w.jobs.size();
+    bool   dynamic = false, registration_over = false, statics_told = false;
+
+    auto stop = [&](size_t i) {
+        st[i].running = false; st[i].done = true;
+        for (uint32_t h : st[i].hosts) busy[h] = false;
+    };
+
+    while (first || !timeline.empty() || !killed.empty()) {
+        std::vector<fb::EventHolder> evs;
+        if (first) {
+            evs.emplace_back(); evs.back().type = fb::Event_BatsimHelloEvent;
+            evs.emplace_back(); evs.back().type = fb::Event_SimulationBeginsEvent;
+            evs.back().sb.n = w.hosts;
+            first = false;
+        } else if (!killed.empty()) {
+            evs.emplace_back(); evs.back().type = fb::Event_JobsKilledEvent;
+        } else {
+            now = timeline.begin()->first;
+            while (!timeline.empty() && timeline.begin()->first == now) {
+                auto [kind, id] = timeline.begin()->second;
+                timeline.erase(timeline.begin());
+                fb::EventHolder e;
+                if (kind == COMPLETION) {
+                    size_t i = index[id];
+                    if (!st[i].running) continue;                       // killed meanwhile
+                    stop(i);
+                    e.type = fb::Event_JobCompletedEvent; e.jc.id.s = id;
+                } else if (kind == SUBMISSION) {
+                    const JobSpec& j = jobs[index[id]];
+                    st[index[id]].submitted = true;
+                    e.type = fb::Event_JobSubmittedEvent; e.js.id.s = id;
+                    e.js.j = fb::Job{j.hosts, j.walltime, FStr{"p" + id}};
+                    --unsubmitted;
+                } else {
+                    pending_calls.erase(id);
+                    e.type = fb::Event_RequestedCallEvent; e.rc.id.s = id;
+                }
+                evs.push_back(e);
+            }
+            if (dynamic && unsubmitted == 0 && !statics_told) {
+                evs.emplace_back(); evs.back().type = fb::Event_AllStaticJobsHaveBeenSubmittedEvent;
+                statics_told = true;
+            }
+        }
+        if (evs.empty()) continue;
+
+        std::vector<FStr> killed_ids;
+        for (const std::string& k : killed) killed_ids.push_back(FStr{k});
+        killed.clear();
+        fb::Message m{now, {}};
+        for (fb::EventHolder& e : evs) {
+            if (e.type == fb::Event_JobsKilledEvent)
+                for (const FStr& k : killed_ids) e.jk.ids.v.push_back(&k);
+            m.ev.v.push_back(&e);
+        }
+
+        uint8_t* buf;
+        uint32_t size;
+        if (pl.take(reinterpret_cast<const uint8_t*>(&m), 0, &buf, &size) != 0) die("%s: decision failed", arg);
+        const Decisions& d = *reinterpret_cast<const Decisions*>(buf);
+        dynamic |= d.dynamic_registration;
+
+        for (const auto& [id, job] : d.registers) {
+            if (!dynamic) die("job %s registered without asking for it", id);
+            if (registration_over) die("job %s registered after the registration ended", id);
+            if (index.count(id)) die("job %s registered twice", id);
+            auto it = index.find(rerun_of(id));
+            if (it == index.end() || !st[it->second].killed)
+                die("job %s registered, not running a killed job again", id);
+            const JobSpec& was = jobs[it->second];
+            if (job.res != was.hosts || job.wt != was.walltime || job.prof != "p" + jobs[st[it->second].origin].id)
+                die("job %s registered as another job than the one it runs again", id);
+            st[it->second].killed = false;                 // runs again: once
+            index[id] = jobs.size();
+            jobs.push_back(JobSpec{id, was.submit, was.walltime, was.runtime, was.hosts});
+            st.emplace_back();
+            st.back().submitted = true;
+            st.back().id = id;
+            st.back().origin = st[it->second].origin;
+        }
+        if (d.registration_finished) {
+            if (!dynamic || registration_over) die("%s: registration ended twice, or never begun", arg);
+            registration_over = true;
+        }
+        if (check) check(now, st, d);
+
+        for (const std::string& k : d.kills) {
+            auto it = index.find(k);
+            if (it == index.end()) die("kill of unknown job %s", k);
+            if (!st[it->second].running) continue;
+            stop(it->second);
+            st[it->second].killed = true;
+            killed.push_back(k);
+        }
+        for (const auto& [id, alloc] : d.execs) {
+            auto it = index.find(id);
+            if (it == index.end()) die("unknown job %s started", id);
+            JobState& s = st[it->second];
+            const JobSpec& j = jobs[it->second];
+            if (s.running || s.done) die("job %s started twice", id);
+            s.hosts = parse_hosts(alloc);
+            if (s.hosts.size() != j.hosts) die("job %s started on the wrong number of hosts", id);
+            for (uint32_t h : s.hosts) {
+                if (h >= w.hosts || busy[h]) die("job %s started on a busy host at %.17g", id, now);
+                busy[h] = true;
+            }
+            s.running = true; s.start = now;
+            timeline.emplace(now + std::min(j.runtime, j.walltime), std::make_pair(COMPLETION, id));
+            char t[32];
+            std::snprintf(t, sizeof t, "%.17g ", now);
+            out += t + id + ' ' + hosts_string(s.hosts) + '\n';
+        }
+        for (const std::string& r : d.rejects) die("job %s rejected", r);
+        for (const auto& [id, t] : d.calls) {
+            if (t < now) die("call-me-later %s in the past", id);
+            if (!pending_calls.insert(id).second) die("call-me-later id %s already pending", id);
+            timeline.emplace(t, std::make_pair(CALL, id));
+        }
+    }
+    pl.deinit();
+    for (size_t i = 0; i < st.size(); ++i) {
+        if (st[i].start < 0) die("job %s never started", st[i].id);
+        if (st[i].killed) die("job %s killed and never run again", st[i].id);
+    }
+    if (dynamic && !registration_over) die("%s: the registration never ended", arg);
+    return out;
+}
+
+/* the plug-in `so` replays w with each of `args` in turn, in the same
+   process; the schedule of the last run is written to fd.  Runs in a
+   child.                                                              */
+void simulate(const char* so, const std::vector<std::string>& args, const Workload& w, int fd,
+              const CallCheck& check)
+{
+    Plugin pl = load(so);
+    std::string out;
+    for (const std::string& arg : args) out = replay(pl, arg, w, check);
+    for (size_t done = 0; done < out.size(); ) {
+        ssize_t k = write(fd, out.data() + done, out.size() - done);
+        if (k <= 0) std::_Exit(2);
+        done += size_t(k);
+    }
+}
+
+/* the schedule simulate() gives, or an empty string if the run failed */
+std::string schedule(const char* so, const std::vector<std::string>& args, const Workload& w,
+                     const CallCheck& check = nullptr)
+{
+    int p[2];
+    if (pipe(p) != 0) { std::perror("pipe"); std::exit(2); }
+    std::fflush(nullptr);
+    pid_t pid = fork();
+    if (pid < 0) { std::perror("fork"); std::exit(2); }
+    if (pid == 0) {
+        close(p[0]);
+        int null = open("/dev/null", O_WRONLY);    // the plug-ins' end-of-run reports
+        if (null >= 0) dup2(null, STDOUT_FILENO);
+        simulate(so, args, w, p[1], check);
+        std::_Exit(0);
+    }
+    close(p[1]);
+    std::string out;
+    char buf[1 << 16];
+    for (ssize_t k; (k = read(p[0], buf, sizeof buf)) > 0; ) out.append(buf, size_t(k));
+    close(p[0]);
+    int status = 0;
+    waitpid(pid, &status, 0);
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) return "";
+    return out;
+}
+
+/* what init returns for `arg`, run in a child; -1 if it did not return */
+int init_status(const char* so, const std::string& arg)
+{
+    std::fflush(nullptr);
+    pid_t pid = fork();
+    if (pid < 0) { std::perror("fork"); std::exit(2); }
+    if (pid == 0) {
+        int null = open("/dev/null", O_WRONLY);    // the plug-in's complaint
+        if (null >= 0) dup2(null, STDERR_FILENO);
+        Plugin pl = load(so);
+        int r = pl.init(reinterpret_cast<const uint8_t*>(arg.data()), uint32_t(arg.size()),
+                        BATSIM_EDC_FORMAT_BINARY);
+        if (r == 0) pl.deinit();
+        std::_Exit(r == 0 ? 0 : 1);
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+/* "" ⇒ the same; otherwise where the two schedules part */
+std::string first_difference(const std::string& a, const std::string& b)
+{
+    std::istringstream sa(a), sb(b);
+    std::string la, lb;
+    for (size_t n = 1; ; ++n) {
+        bool ea = !std::getline(sa, la), eb = !std::getline(sb, lb);
+        if (ea && eb) return "";
+        if (ea || eb || la != lb)
+            return "start " + std::to_string(n) + ": '" + (ea ? "(none)" : la) +
+                   "' vs '" + (eb ? "(none)" : lb) + "'";
+    }
+}
+
+int failures = 0;
+
+void expect_same(const std::string& a, const std::string& b, const std::string& what,
+                 const std::string& name)
+{
+    std::string diff = a.empty() || b.empty() ? "a run failed" : first_difference(a, b);
+    if (diff.empty()) return;
+    std::fprintf(stderr, "%s: %s: %s\n", name.c_str(), what.c_str(), diff.c_str());
+    ++failures;
+}
+
+void compare(const char* so_a, const std::string& arg_a, const char* so_b, const std::string& arg_b,
+             const Workload& w, const std::string& name)
+{
+    expect_same(schedule(so_a, {arg_a}, w), schedule(so_b, {arg_b}, w),
+                "\"" + arg_a + "\" vs \"" + arg_b + "\"", name);
+}
+
+/* start instants of a schedule, by job id */
+std::unordered_map<std::string, double> start_times(const std::string& schedule)
+{
+    std::unordered_map<std::string, double> out;
+    std::istringstream in(schedule);
+    double t;
+    std::string id, hosts;
+    while (in >> t >> id >> hosts) out[id] = t;
+    return out;
+}
+
+/* the run of `arg` must start every job of w at want[i] */
+void expect_starts(const char* so, const std::string& arg, const Workload& w,
+                   const std::vector<double>& want, const std::string& name)
+{
+    std::string sched = schedule(so, {arg}, w);
+    std::string diff = sched.empty() ? "the run failed" : "";
+    auto got = start_times(sched);
+    for (size_t i = 0; i < w.jobs.size() && diff.empty(); ++i)
+        if (got[w.jobs[i].id] != want[i]) {
+            char t[96];
+            std::snprintf(t, sizeof t, "job %s started at %.17g, not %.17g",
+                          w.jobs[i].id.c_str(), got[w.jobs[i].id], want[i]);
+            diff = t;
+        }
+    if (diff.empty()) return;
+    std::fprintf(stderr, "%s: \"%s\": %s\n", name.c_str(), arg.c_str(), diff.c_str());
+    ++failures;
+}
+
+/* hosts a plain EASY pass starts from the state at a call: the heads
+   while they fit, then, for the blocked head, the jobs in backfill order
+   that fit then and end by its reservation or, with extra_nodes, fit in
+   the hosts it leaves over then.  `fitting` is how many of them fitted
+   on their own before any started; `picked`, if given, gets the jobs.  */
+uint64_t greedy_pass(const Workload& w, const std::vector<JobState>& st, double now,
+                     Policy primary, Policy backfill, bool extra_nodes, size_t& fitting,
+                     std::set<size_t>* picked = nullptr)
+{
+    struct Keyed { uint32_t nb_hosts; double walltime, submit_time; };
+    auto order = [&](Policy p) {
+        return [&w, now, p](size_t a, size_t b) {
+            Keyed ja{w.jobs[a].hosts, w.jobs[a].walltime, w.jobs[a].submit};
+            Keyed jb{w.jobs[b].hosts, w.jobs[b].walltime, w.jobs[b].submit};
+            double ka = key_for(&ja, now, p), kb = key_for(&jb, now, p);
+            return ka < kb || (ka == kb && a < b);
+        };
+    };
+    std::vector<size_t> pending;
+    std::multimap<double, uint32_t> releases;
+    uint32_t free = w.hosts;
+    for (size_t i = 0; i < st.size(); ++i) {
+        if (st[i].running) {
+            free -= w.jobs[i].hosts;
+            releases.emplace(st[i].start + w.jobs[i].walltime, w.jobs[i].hosts);
+        } else if (st[i].submitted && st[i].start < 0) {
+            pending.push_back(i);
+        }
+    }
+    std::sort(pending.begin(), pending.end(), order(primary));
+
+    uint64_t started = 0;
+    size_t   h = 0;
+    fitting = 0;
+    for (; h < pending.size() && w.jobs[pending[h]].hosts <= free; ++h) {
+        const JobSpec& j = w.jobs[pending[h]];
+        free -= j.hosts; started += j.hosts;
+        releases.emplace(now + j.walltime, j.hosts);
+        if (picked) picked->insert(pending[h]);
+    }
+    if (h == pending.size()) return started;
+
+    const uint32_t need = w.jobs[pending[h]].hosts;
+    uint64_t acc = free;
+    double   shadow = now;
+    for (const auto& [t, q] : releases) {
+        if (acc >= need) break;
+        acc += q; shadow = t;
+    }
+    uint64_t extra = 0;
+    if (extra_nodes) {
+        for (const auto& [t, q] : releases) if (t <= shadow) extra += q;
+        extra = extra + free - need;
+    }
+    auto fits = [&](size_t i) {
+        return w.jobs[i].hosts <= free &&
+               (now + w.jobs[i].walltime <= shadow || w.jobs[i].hosts <= extra);
+    };
+    std::vector<size_t> rest(pending.begin() + long(h) + 1, pending.end());
+    std::sort(rest.begin(), rest.end(), order(backfill));
+    for (size_t i : rest) if (fits(i)) ++fitting;
+    for (size_t i : rest)
+        if (fits(i)) {
+            if (now + w.jobs[i].walltime > shadow) extra -= w.jobs[i].hosts;
+            free -= w.jobs[i].hosts; started += w.jobs[i].hosts;
+            if (picked) picked->insert(i);
+        }
+    return started;
+}
+
+/* #los: at each call where the jobs that fit number no more than
+   `window`, so that they go into one selection, it starts at least as
+   many hosts as the greedy pass                                      */
+CallCheck no_fewer_than_greedy(const Workload& w, Policy primary, Policy backfill,
+                               bool extra_nodes, size_t window)
+{
+    return [&w, primary, backfill, extra_nodes, window](double now, const std::vector<JobState>& st,
+                                                        const Decisions& d) {
+        size_t   fitting = 0;
+        uint64_t greedy  = greedy_pass(w, st, now, primary, backfill, extra_nodes, fitting), got = 0;
+        for (const auto& [id, hosts] : d.execs) got += parse_hosts(hosts).size();
+        if (fitting <= window && got < greedy)
+            die("%s hosts started at %.17g, fewer than the greedy pass",
+                std::to_string(got), now);
+    };
+}
+
+/* #adapt: every call starts the jobs a plain EASY pass would under one
+   of the candidate pairs, the pair in force unless it just switched    */
+CallCheck as_one_of(const Workload& w, const std::vector<std::pair<Policy, Policy>>& pairs,
+                    bool extra_nodes)
+{
+    return [&w, pairs, extra_nodes, cur = size_t(0)]
+           (double now, const std::vector<JobState>& st, const Decisions& d) mutable {
+        std::set<size_t> got, want;
+        for (const auto& [id, hosts] : d.execs) got.insert(std::stoul(id) - 1);
+        for (size_t k = 0; k < pairs.size(); ++k) {
+            size_t c = (cur + k) % pairs.size(), fitting = 0;
+            want.clear();
+            greedy_pass(w, st, now, pairs[c].first, pairs[c].second, extra_nodes, fitting, &want);
+            if (want != got) continue;
+            cur = c;
+            return;
+        }
+        die("%s: the jobs started at %.17g are those of no candidate order", "#adapt", now);
+    };
+}
+ 
+/* #spec under FCFS: a call kills jobs only while the head of the queue,
+   its oldest waiting job, needs more hosts than are free, and only jobs
+   it needs: without any one of them, the free hosts and the other
+   killed jobs' would not be enough                                     */
+CallCheck kills_for_the_head(const Workload& w)
+{
+    return [&w](double now, const std::vector<JobState>& st, const Decisions& d) {
+        if (d.kills.empty()) return;
+        uint64_t free = w.hosts, killed = 0;
+        const JobState* head = nullptr;
+        for (const JobState& s : st) {
+            if (s.running) free -= s.hosts.size();
+            else if (s.submitted && s.start < 0 && (!head || s.origin < head->origin)) head = &s;
+        }
+        std::vector<uint64_t> widths;
+        for (const std::string& k : d.kills)
+            for (const JobState& s : st)
+                if (s.id == k && s.running) { widths.push_back(s.hosts.size()); killed += s.hosts.size(); }
+        const uint64_t need = head ? w.jobs[head->origin].hosts : 0;
+        if (need <= free) die("%s killed at %.17g, the head not waiting", d.kills.front(), now);
+        for (uint64_t q : widths)
+            if (free + killed - q >= need)
+                die("%s: a job killed at %.17g that the head does not need", "#spec", now);
+    };
+}
+
+/* the order in ".../libeasy_P_P.so" */
+std::string order_of(const std::string& path)
+{
+    size_t b = path.rfind("easy_");
+    if (b == std::string::npos) return "";
+    b += 5;
+    return path.substr(b, path.find('_', b) - b);
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: test_schedules libeasy_variants.so [libeasy_P_P.so...]\n");
+        return 2;
+    }
+    const char* unified = argv[1];
+
+    /* built-in orders and the same keys as expressions (policies.hpp) */
+    const std::string F = "submit_time", L = "-submit_time", Q = "nb_hosts", LQ = "-nb_hosts",
+                      S = "walltime", LP = "-walltime", E = "-((submit_age+walltime)/walltime)";
+    const std::pair<std::string, std::string> spelled[] = {
+        {"fcfs", F}, {"lcfs", L}, {"sqf", Q}, {"lqf", LQ}, {"spf", S}, {"lpf", LP}, {"exp", E},
+        {"lqf,lpf", LQ + "," + LP}, {"spf,exp", S + "," + E}, {"exp,fcfs", E + "," + F},
+        {"spf@1", S + "@1"}, {"lqf,lpf@1", LQ + "," + LP + "@1"}, {"exp@2", E + "@2"},
+        {"fcfs,spf@0.5", F + "," + S + "@0.5"}, {"spf#extra", S + "#extra"},
+        {"exp,lpf@1#extra", E + "," + LP + "@1#extra"},
+    };
+
+    /* a run after another in the same process (init, deinit, init) must
+       not keep anything of the first one                               */
+    const std::pair<std::string, std::string> reruns[] = {
+        {"lqf,lpf@1#extra#k3", "spf"}, {"exp@2#cons", "fcfs,spf"},
+        {"spf@1#los#extra", "lqf"}, {Q + ";" + LP + "@1", "exp"},
+    };
+
+    size_t runs = 0;
+    for (uint64_t seed : {1, 2, 3})
+        for (uint32_t hosts : {16u, 40u}) {
+            Workload w = make_workload(seed, hosts, 300);
+            std::string name = "seed " + std::to_string(seed) + ", " + std::to_string(hosts) + " hosts";
+            for (int i = 2; i < argc; ++i, ++runs)
+                compare(unified, order_of(argv[i]), argv[i], "", w, name);
+            for (const auto& [builtin, expr] : spelled) {
+                compare(unified, builtin, unified, expr, w, name);
+                ++runs;
+            }
+
+            /* #cons: with every job running its walltime nothing is ever
+               compressed, so each job starts at the reservation it got on
+               submission, whatever the orders                           */
+            Workload exact = runs_walltime(w);
+            std::vector<double> reserved = conservative_starts(exact);
+            for (const char* arg : {"fcfs#cons", "spf,lpf@1#cons", "exp,lqf#cons"}) {
+                expect_starts(unified, arg, exact, reserved, name);
+                ++runs;
+            }
+
+            /* #pred learns from the completions: when every job runs its
+               walltime, it predicts the walltimes and plans as plain EASY */
+            for (const char* arg : {"fcfs", "spf,lpf@1#extra", "exp,lqf"}) {
+                compare(unified, arg, unified, arg + std::string("#pred"), exact, name);
+                ++runs;
+            }
+
+            /* #los picks, among the jobs that fit, the subset using the most
+               hosts: never fewer than the first ones that fit (greedy).  On
+               the wide machine the #extra table is cut down to 8 candidates
+               and counts hosts in blocks.                                  */
+            Workload wide = widen(w, 256);
+            const std::tuple<const char*, Policy, Policy> los[] = {
+                {"fcfs#los", Policy::FCFS, Policy::FCFS}, {"spf#los", Policy::SPF, Policy::SPF},
+                {"lqf,spf#los", Policy::LQF, Policy::SPF}, {"exp,lpf#los", Policy::EXP, Policy::LPF},
+                {"fcfs#los#extra", Policy::FCFS, Policy::FCFS},
+                {"lqf,spf#los#extra", Policy::LQF, Policy::SPF},
+            };
+            for (const auto& [arg, p, b] : los) {
+                bool extra = std::strstr(arg, "#extra") != nullptr;
+                for (const Workload* on : {&w, &wide}) {
+                    CallCheck c = no_fewer_than_greedy(*on, p, b, extra, on == &w ? 64 : 8);
+                    if (schedule(unified, {arg}, *on, c).empty()) {
+                        std::fprintf(stderr, "%s%s: \"%s\": the run failed\n", name.c_str(),
+                                     on == &w ? "" : " x256", arg);
+                        ++failures;
+                    }
+                    ++runs;
+                }
+            }
+
+            /* #adapt switches between plain EASY orders, handing the queue over */
+            using Pairs = std::vector<std::pair<Policy, Policy>>;
+            const Pairs std_pairs{{Policy::FCFS, Policy::FCFS}, {Policy::SPF, Policy::SPF},
+                                  {Policy::EXP, Policy::EXP}};
+            const std::tuple<const char*, Pairs, bool> adapts[] = {
+                {"fcfs#adapt", std_pairs, false},
+                {"lqf,spf#adapt=spf/lqf,lpf/exp#extra#target=bsld",
+                 {{Policy::LQF, Policy::SPF}, {Policy::SPF, Policy::SPF},
+                  {Policy::LQF, Policy::LPF}, {Policy::EXP, Policy::EXP}}, true},
+                {"exp#adapt#target=maxwait", {{Policy::EXP, Policy::EXP}, {Policy::FCFS, Policy::FCFS},
+                                              {Policy::SPF, Policy::SPF}}, false},
+            };
+            for (const auto& [arg, pairs, extra] : adapts) {
+                if (schedule(unified, {arg}, w, as_one_of(w, pairs, extra)).empty()) {
+                    std::fprintf(stderr, "%s: \"%s\": the run failed\n", name.c_str(), arg);
+                    ++failures;
+                }
+                ++runs;
+            }
+            compare(unified, "spf,lpf", unified, "spf,lpf#adapt=spf,lpf", w, name);   // one pair ⇒ off
+            ++runs;
+
+            /* #tune holds the threshold within [target/100, target]: with
+               waits far below a target it starts at, it never moves      */
+            for (auto [order, more] : {std::make_pair("spf", ""), std::make_pair("lqf,lpf", "#extra")}) {
+                compare(unified, order + std::string("@10000") + more,
+                        unified, order + std::string(more) + "#tune=10000", w, name);
+                ++runs;
+            }
+
+            /* #spec kills for the head only, and every killed job runs again */
+            for (const char* arg : {"fcfs#spec", "fcfs,spf#spec#extra", "spf@1#spec", "exp,lpf#spec"}) {
+                CallCheck c = std::strncmp(arg, "fcfs", 4) == 0 ? kills_for_the_head(w) : nullptr;
+                if (schedule(unified, {arg}, w, c).empty()) {
+                    std::fprintf(stderr, "%s: \"%s\": the run failed\n", name.c_str(), arg);
+                    ++failures;
+                }
+                ++runs;
+            }
+
+            /* #kN: one reservation is EASY, more than there are jobs is #cons */
+            for (const char* arg : {"fcfs", "spf,lpf@1#extra", "exp,lqf"}) {
+                compare(unified, arg, unified, arg + std::string("#k1"), w, name);
+                compare(unified, arg + std::string("#cons"), unified, arg + std::string("#k1000"), w, name);
+                runs += 2;
+            }
+
+            for (const auto& [first, arg] : reruns) {
+                expect_same(schedule(unified, {arg}, w), schedule(unified, {first, arg}, w),
+                            "\"" + arg + "\" after \"" + first + "\"", name);
+                ++runs;
+            }
+        }
+
+    /* a bad #kN is an init error, not an exception through the C interface */
+    for (const char* arg : {"fcfs#k0", "fcfs#k99999999999999999999999", "spf#k12x", "fcfs#k2097152"}) {
+        int r = init_status(unified, arg);
+        if (r <= 0) {
+            std::fprintf(stderr, "\"%s\": init %s\n", arg, r < 0 ? "crashed" : "accepted it");
+            ++failures;
+        }
+        ++runs;
+    }
+
+    if (failures) {
+        std::fprintf(stderr, "schedules: %d of %zu comparisons differ\n", failures, runs);
+        return 1;
+    }
+    std::printf("schedules: ok, %zu comparisons\n", runs);
+    return 0;
+}
@@ -0,0 +1,63 @@
+/**************************************************************
+ *  slab_pool.cpp  —  SlabPool against the indices held and
+ *                    released
+ *
+ *  Small chunks, and phases that mostly acquire then mostly
+ *  release, so that the pool grows by many chunks and recycles
+ *  a lot.  An acquired index must be the one released last, or
+ *  the next one past the extent when none is spare; a value
+ *  written at an index must still be there when it is released;
+ *  and the counters must match the operations made.
+ *
+ *      ./test_slab_pool [seed]
+ *************************************************************/
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <set>
+#include <vector>
+
+#include "check.hpp"
+#include "slab_pool.hpp"
+
+int main(int argc, char** argv)
+{
+    auto g = check::rng_from(argc, argv);
+    using check::below;
+
+    constexpr uint32_t CHUNK = 8;
+    SlabPool<uint64_t, CHUNK> pool;
+    std::set<uint32_t>    held;
+    std::vector<uint32_t> spare;         // released, most recent last
+    uint64_t acquired = 0, recycled = 0, released = 0;
+    size_t   peak = 0;
+    uint32_t extent = 0;
+    for (int i = 0; i < 20000; ++i, ++check::step) {
+        if (held.empty() || below(g, 0, 99) < (i % 4000 < 2000 ? 60u : 40u)) {
+            uint32_t k = pool.acquire();
+            /* the index released last is reused before the pool grows */
+            if (spare.empty()) { CHECK(k == extent); ++extent; }
+            else { CHECK(k == spare.back()); spare.pop_back(); ++recycled; }
+            ++acquired;
+            held.insert(k);
+            pool[k] = uint64_t(k) * 7 + 1;
+            peak = std::max(peak, held.size());
+        } else {
+            auto it = held.begin();
+            std::advance(it, long(below(g, 0, held.size() - 1)));
+            CHECK(pool[*it] == uint64_t(*it) * 7 + 1);
+            pool.release(*it);
+            spare.push_back(*it);
+            held.erase(it);
+            ++released;
+        }
+        const SlabStats& st = pool.stats();
+        CHECK(pool.extent() == extent);
+        CHECK(st.acquired == acquired && st.recycled == recycled && st.released == released);
+        CHECK(st.live == held.size() && st.peak == peak);
+        CHECK(st.chunks == (extent + CHUNK - 1) / CHUNK);
+    }
+    pool.clear();
+    CHECK(pool.extent() == 0 && pool.stats().live == 0);
+    return check::pass("slab_pool");
+}
@@ -0,0 +1,192 @@
+/**************************************************************
+ *  speculation.cpp  —  Speculation's kill choice against the
+ *                      head's reservation recomputed from the
+ *                      release steps
+ *
+ *  Running jobs, some speculative with their kill instant past,
+ *  others not yet due, killed or spared before, or ordinary;
+ *  many steps at equal times, and heads that fit, wait for a
+ *  few hosts or for more than will ever be free.  After each
+ *  kill_overruns(), every due job must be either killed or
+ *  spared to its walltime, none of the others touched; nothing
+ *  killed unless the head waits; the head's reservation must be
+ *  the one it had with every due job killed, and sparing any
+ *  killed one as well must put it later.  Also the ids a killed
+ *  job runs again under, and when registration may end.
+ *
+ *      ./test_speculation [seed]
+ *************************************************************/
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "availability_profile.hpp"
+#include "check.hpp"
+#include "job_table.hpp"
+#include "speculation.hpp"
+
+namespace {
+
+struct Rec {
+    double   kill_at      = HUGE_VAL;
+    double   req_walltime = 0;
+};
+
+/* earliest instant >= now with free + releases >= need, else the last release */
+double naive_earliest(const std::multimap<double, uint32_t>& steps, double now,
+                      uint32_t free, uint32_t need)
+{
+    if (free >= need || steps.empty()) return now;
+    uint64_t acc = free;
+    double   t   = now;
+    for (const auto& [rt, q] : steps) {
+        acc += q; t = rt;
+        if (acc >= need) break;
+    }
+    return t > now ? t : now;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    auto g = check::rng_from(argc, argv);
+    using check::below;
+
+    JobTable<Rec>       jobs;
+    AvailabilityProfile profile;
+    Speculation         spec;
+    uint64_t kills = 0, spares = 0;
+    for (int round = 0; round < 3000; ++round, ++check::step) {
+        jobs.clear(); profile.clear(); spec.clear();
+        const double now = 1000;
+        std::vector<JobHandle> all;
+        double   next_kill = HUGE_VAL;    // first kill instant to come, of jobs gone too
+        uint32_t busy = 0;
+        for (uint64_t n = below(g, 0, 12); n > 0; --n) {
+            JobHandle h = jobs.intern(std::to_string(all.size()));
+            auto& run = jobs.running(h);
+            Rec&  rec = jobs.record(h);
+            run.active       = true;
+            run.nb_hosts     = uint32_t(below(g, 1, 8));
+            run.start        = double(below(g, 0, 9)) * 100;
+            rec.req_walltime = now - run.start + double(below(g, 1, 6)) * 100;
+            uint64_t kind = below(g, 0, 5);
+            if (kind < 3) {                                      // speculative
+                rec.kill_at = kind < 2 ? double(below(g, 9, 10)) * 100        // due
+                                       : now + double(below(g, 1, 3)) * 100;  // later
+                run.end = rec.kill_at;
+                spec.started(h, rec.kill_at);
+                if (rec.kill_at > now) next_kill = std::min(next_kill, rec.kill_at);
+                if (kind == 0 && below(g, 0, 4) == 0) {          // spared before: no longer due
+                    rec.kill_at = HUGE_VAL;
+                    run.end = run.start + rec.req_walltime;
+                }
+            } else {
+                run.end = std::min(run.start + rec.req_walltime, now + double(below(g, 0, 5)) * 100);
+            }
+            profile.add(run.end, run.nb_hosts);
+            busy += run.nb_hosts;
+            all.push_back(h);
+        }
+        if (!all.empty() && below(g, 0, 5) == 0) {               // completed meanwhile
+            JobHandle h = all[below(g, 0, all.size() - 1)];
+            profile.remove(jobs.running(h).end, jobs.running(h).nb_hosts);
+            jobs.retire(h);
+        }
+
+        const uint32_t free = uint32_t(below(g, 0, 6));
+        const uint32_t need = below(g, 0, 3) == 0 ? uint32_t(below(g, 0, free))
+                                                  : uint32_t(below(g, free + 1, free + busy + 4));
+        std::vector<JobHandle> due;
+        std::vector<double>    ends(all.size()), kill_at(all.size());
+        std::multimap<double, uint32_t> killed_steps;           // every due job at its step
+        for (size_t i = 0; i < all.size(); ++i) {
+            if (!jobs.alive(all[i])) continue;
+            ends[i] = jobs.running(all[i]).end; kill_at[i] = jobs.record(all[i]).kill_at;
+            if (kill_at[i] <= now) due.push_back(all[i]);
+            killed_steps.emplace(ends[i], jobs.running(all[i]).nb_hosts);
+        }
+        const double r0 = naive_earliest(killed_steps, now, free, need);
+
+        std::vector<std::string> ids;
+        double woken = -1;
+        bool moved = spec.kill_overruns(now, jobs, profile, free, need,
+                                        [&](const std::vector<std::string>& k){ ids = k; },
+                                        [&](double t){ woken = t; });
+
+        std::multimap<double, uint32_t> steps;
+        std::vector<uint32_t> killed;
+        size_t spared = 0;
+        for (size_t i = 0; i < all.size(); ++i) {
+            JobHandle h = all[i];
+            if (!jobs.alive(h)) continue;
+            const auto& run = jobs.running(h);
+            const Rec&  rec = jobs.record(h);
+            bool is_due = kill_at[i] <= now;
+            bool is_killed = std::count(ids.begin(), ids.end(), jobs.id(h)) == 1;
+            CHECK(!is_killed || is_due);
+            if (!is_due) {
+                CHECK(run.end == ends[i] && rec.kill_at == kill_at[i]);
+            } else if (is_killed) {
+                CHECK(run.end == ends[i] && rec.kill_at == kill_at[i]);
+                killed.push_back(run.nb_hosts);
+            } else {
+                CHECK(run.end == run.start + rec.req_walltime && rec.kill_at == HUGE_VAL);
+                ++spared;
+            }
+            steps.emplace(run.end, run.nb_hosts);
+        }
+        CHECK(ids.size() == killed.size());
+        CHECK(killed.size() + spared == due.size());
+        CHECK(moved == (spared > 0));
+        CHECK(woken == (next_kill == HUGE_VAL ? -1 : next_kill));
+        if (need <= free) CHECK(killed.empty());
+
+        /* the profile holds the steps, and the head's reservation is r0 */
+        for (uint32_t f = 0; f <= free; ++f)
+            for (uint32_t q = 0; q <= need + 2; ++q)
+                CHECK(profile.earliest(now, f, q) == naive_earliest(steps, now, f, q));
+        CHECK(naive_earliest(steps, now, free, need) == r0);
+
+        /* each one killed is needed: spared as well, the head waits longer */
+        for (const std::string& id : ids) {
+            JobHandle h = jobs.lookup(id);
+            const auto& run = jobs.running(h);
+            std::multimap<double, uint32_t> without = steps;
+            auto it = without.find(run.end);
+            while (it->second != run.nb_hosts) ++it;
+            without.erase(it);
+            without.emplace(run.start + jobs.record(h).req_walltime, run.nb_hosts);
+            CHECK(naive_earliest(without, now, free, need) > r0);
+        }
+        kills += killed.size(); spares += spared;
+    }
+    CHECK(kills > 0 && spares > 0);
+
+    /* a job runs again as "<id>#r1", "<id>#r2"... whatever its id */
+    uint32_t n = 0;
+    CHECK(spec.requeue_id("w0!7", n) == "w0!7#r1" && n == 1);
+    CHECK(spec.requeue_id("w0!7#r1", n) == "w0!7#r2" && n == 2);
+    n = 0;
+    CHECK(spec.requeue_id("a#r3", n) == "a#r3#r1" && n == 1);
+    CHECK(spec.profile_index("p1") == spec.profile_index("p1"));
+    CHECK(spec.profile(spec.profile_index("p2")) == "p2");
+
+    /* registration ends once every static job is in, none waits and no
+       speculative one runs                                              */
+    spec.clear();
+    JobHandle h = jobs.intern("x");
+    spec.started(h, 10);
+    CHECK(spec.registering() && !spec.may_close(0));
+    spec.all_submitted();
+    CHECK(!spec.may_close(0));
+    spec.completed(1);
+    CHECK(!spec.may_close(1) && spec.may_close(0));
+    spec.close();
+    CHECK(!spec.registering() && !spec.may_close(0));
+    return check::pass("speculation");
+}
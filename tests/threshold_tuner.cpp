@@ -0,0 +1,108 @@
+/**************************************************************
+ *  threshold_tuner.cpp  —  ThresholdTuner against the rule its
+ *                          header states
+ *
+ *  Random targets, and waits whose scale jumps now and then and
+ *  otherwise stays put, so that p99 rises, falls and plateaus.
+ *  The test keeps its own sketch of the same waits, so it knows
+ *  the p99 each period saw.  After each period the threshold
+ *  must be unchanged below MIN_WEIGHT and within the deadband,
+ *  or else moved by sqrt(target / p99) within [target/100,
+ *  target].  It may be held instead only at a bound, or when a
+ *  move the same way left p99 no closer than the period before,
+ *  and then never more than REARM periods in a row.
+ *
+ *      ./test_threshold_tuner [seed]
+ *************************************************************/
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include <unistd.h>
+
+#include "check.hpp"
+#include "quantile_sketch.hpp"
+#include "threshold_tuner.hpp"
+
+int main(int argc, char** argv)
+{
+    auto g = check::rng_from(argc, argv);
+    using check::below;
+    using T = ThresholdTuner;
+
+    /* the tuner logs its changes: not to the test's output */
+    std::fflush(stdout);
+    int out = dup(STDOUT_FILENO);
+    if (!std::freopen("/dev/null", "w", stdout)) return 2;
+
+    ThresholdTuner tuner;
+    uint64_t moves = 0, rearmed = 0;
+    for (int round = 0; round < 40; ++round) {
+        const double target = 600 * std::exp2(double(below(g, 0, 80)) / 10);   // 10 min to ~60 h
+        double thr = target / 100 * std::exp2(double(below(g, 0, 66)) / 10);
+        thr = std::min(thr, target);
+        tuner.clear();
+        tuner.set_target(target);
+        CHECK(tuner.on());
+
+        QuantileSketch waits;
+        double scale = target * std::exp2(double(below(g, 0, 120)) / 10 - 7);
+        double prev  = 0;             // p99 of the last period past MIN_WEIGHT
+        int    dir   = 0;             // of the last move
+        uint32_t held = 0;            // periods held in a row on no effect
+        for (int k = 0; k < 300; ++k, ++check::step) {
+            const double now = k * T::PERIOD;
+            if (below(g, 0, 9) == 0)
+                scale = target * std::exp2(double(below(g, 0, 120)) / 10 - 7);
+            std::lognormal_distribution<double> wait(std::log(scale), 0.7);
+            for (uint64_t n = below(g, 0, 3) == 0 ? 0 : below(g, 1, 80); n > 0; --n) {
+                double w = wait(g);
+                tuner.started(w);
+                waits.add(w);
+            }
+            std::vector<double> pending(below(g, 0, 20));
+            for (double& w : pending) w = wait(g);
+
+            CHECK(tuner.due(now));
+            double got = tuner.tune(now, thr, [&](auto add){ for (double w : pending) add(w); },
+                                    "threshold_tuner");
+            CHECK(!tuner.due(now));
+
+            waits.decay(std::exp2(-T::PERIOD / T::HALF_LIFE));
+            QuantileSketch all = waits;
+            for (double w : pending) all.add(w);
+            CHECK(tuner.p99() == waits.quantile(0.99));
+            if (all.weight() < T::MIN_WEIGHT) { CHECK(got == thr); continue; }
+
+            const double q = all.quantile(0.99), ratio = target / std::max(q, 1.0);
+            const double before = prev;
+            prev = q;
+            if (std::fabs(ratio - 1.0) < T::DEADBAND) { CHECK(got == thr); held = 0; continue; }
+            const int    d    = ratio < 1 ? -1 : 1;
+            const double move = std::clamp(thr * std::sqrt(std::clamp(ratio, 0.25, 4.0)),
+                                           target / 100, target);
+            if (got != thr) {
+                CHECK(got == move);
+                CHECK(got >= target / 100 && got <= target);
+                CHECK((got < thr) == (d < 0));
+                if (held == T::REARM) ++rearmed;
+                dir = d; held = 0; thr = got; ++moves;
+                continue;
+            }
+            if (move == thr) continue;                       // pinned at a bound
+            CHECK(d == dir);
+            CHECK(std::fabs(std::log(q / target)) >= std::fabs(std::log(before / target)));
+            CHECK(held < T::REARM);
+            ++held;
+        }
+    }
+
+    std::fflush(stdout);
+    dup2(out, STDOUT_FILENO);
+    close(out);
+    CHECK(moves > 0 && rearmed > 0);                         // both paths were taken
+    return check::pass("threshold_tuner");
+}
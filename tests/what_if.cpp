@@ -0,0 +1,170 @@
+/**************************************************************
+ *  what_if.cpp  —  WhatIfReplay against a naive EASY replay
+ *
+ *  The reference replays the same snapshot the plain way: at
+ *  each release it sorts the waiting jobs afresh, starts the
+ *  head while it fits, computes the head's reservation by
+ *  scanning every release step, and backfills in backfill order.
+ *  Random snapshots are replayed under every pair of orders,
+ *  with and without aging and extra nodes, for the three metrics,
+ *  several times on the same WhatIfReplay; the scores must be
+ *  equal.  A replay given too small a budget may give no score,
+ *  but never another one.
+ *
+ *      ./test_what_if [seed]
+ *************************************************************/
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "check.hpp"
+#include "policies.hpp"
+#include "what_if.hpp"
+
+namespace {
+
+const Policy POLICIES[] = {Policy::EXP, Policy::FCFS, Policy::LCFS, Policy::LPF,
+                           Policy::LQF, Policy::SPF, Policy::SQF};
+
+double naive_replay(const WhatIfSnapshot& s, Policy p, Policy b, const WhatIfParams& prm)
+{
+    const size_t n = s.pending.size();
+    std::vector<std::pair<double, uint32_t>> rel = s.releases;    // still to come
+    std::vector<bool> done(n, false);
+    uint32_t free = s.free;
+    double   sum = 0, worst = 0;
+    auto score = [&](const WhatIfJob& j, double t) {
+        double wait = t - j.submit_time;
+        worst = std::max(worst, wait);
+        sum  += prm.metric == WhatIfMetric::BSLD
+                    ? std::max(1.0, (wait + j.walltime) / std::max(j.walltime, 10.0))
+                    : wait;
+    };
+    /* waiting jobs sorted at t: aged first with aging, then key, then arrival */
+    auto sorted = [&](Policy pol, double t, bool aging) {
+        std::vector<uint32_t> v;
+        for (uint32_t i = 0; i < n; ++i) if (!done[i]) v.push_back(i);
+        std::sort(v.begin(), v.end(), [&](uint32_t x, uint32_t y) {
+            const WhatIfJob& a = s.pending[x];
+            const WhatIfJob& c = s.pending[y];
+            if (aging) {
+                bool aa = t - a.submit_time > prm.threshold, ac = t - c.submit_time > prm.threshold;
+                if (aa != ac) return aa;
+            }
+            double ka = key_for(&a, t, pol), kc = key_for(&c, t, pol);
+            return ka < kc || (ka == kc && a.seq < c.seq);
+        });
+        return v;
+    };
+    auto start = [&](uint32_t i, double t) {
+        done[i] = true;
+        free -= s.pending[i].nb_hosts;
+        rel.emplace_back(t + s.pending[i].walltime, s.pending[i].nb_hosts);
+        score(s.pending[i], t);
+    };
+
+    const double end = s.now + prm.horizon;
+    double t = s.now;
+    for (;;) {
+        for (size_t k = 0; k < rel.size(); )
+            if (rel[k].first <= t) { free += rel[k].second; rel.erase(rel.begin() + long(k)); }
+            else ++k;
+
+        std::vector<uint32_t> prim = sorted(p, t, prm.threshold >= 0);
+        size_t h = 0;
+        while (h < prim.size() && s.pending[prim[h]].nb_hosts <= free) start(prim[h++], t);
+        if (h == prim.size()) break;
+
+        /* the head's reservation: first release step by which it fits */
+        const uint32_t need = s.pending[prim[h]].nb_hosts;
+        double shadow = HUGE_VAL;
+        for (const auto& r : rel) {
+            uint64_t avail = free;
+            for (const auto& o : rel) if (o.first <= r.first) avail += o.second;
+            if (avail >= need) shadow = std::min(shadow, r.first);
+        }
+        if (free >= need) shadow = t;
+        uint32_t extra = 0;
+        if (prm.extra_nodes && shadow != HUGE_VAL) {
+            uint64_t avail = free;
+            for (const auto& o : rel) if (o.first <= shadow) avail += o.second;
+            extra = uint32_t(avail - need);
+        }
+
+        for (uint32_t i : sorted(b, t, false)) {
+            if (free == 0) break;
+            const WhatIfJob& j = s.pending[i];
+            if (i == prim[h] || done[i] || j.nb_hosts > free) continue;
+            if (t + j.walltime > shadow) {
+                if (j.nb_hosts > extra) continue;
+                extra -= j.nb_hosts;
+            }
+            start(i, t);
+        }
+
+        double nt = HUGE_VAL;
+        for (const auto& r : rel) nt = std::min(nt, r.first);
+        if (nt > end) break;
+        t = nt;
+    }
+    /* jobs still waiting, in the primary order of the last pass (the sum's order) */
+    for (uint32_t i : sorted(p, t, prm.threshold >= 0)) score(s.pending[i], end);
+    return prm.metric == WhatIfMetric::MAX_WAIT ? worst : (n ? sum / n : 0.0);
+}
+
+std::shared_ptr<WhatIfSnapshot> make_snapshot(std::mt19937_64& g)
+{
+    using check::below;
+    auto s = std::make_shared<WhatIfSnapshot>();
+    const uint32_t hosts = uint32_t(below(g, 1, 64));
+    const uint64_t scale = below(g, 10, 5000);             // small ⇒ many ties
+    s->now = double(below(g, 0, 100000));
+    uint32_t busy = uint32_t(below(g, 0, hosts));
+    s->free = hosts - busy;
+    while (busy > 0) {
+        uint32_t q = uint32_t(below(g, 1, busy));
+        s->releases.emplace_back(s->now + double(below(g, 0, scale)), q);
+        busy -= q;
+    }
+    std::sort(s->releases.begin(), s->releases.end());
+    const size_t n = below(g, 0, 60);
+    double sub = s->now - double(below(g, 0, 4 * scale));
+    for (uint64_t i = 0; i < n; ++i) {
+        s->pending.push_back(WhatIfJob{uint32_t(below(g, 1, hosts)),
+                                       double(below(g, 1, scale)), sub, i});
+        sub = std::min(s->now, sub + double(below(g, 0, scale / 4)));
+    }
+    return s;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    auto g = check::rng_from(argc, argv);
+    using check::below;
+
+    for (int i = 0; i < 300; ++i) {
+        auto snap = make_snapshot(g);
+        WhatIfReplay replay(snap);
+        for (int k = 0; k < 12; ++k, ++check::step) {
+            Policy p = POLICIES[below(g, 0, 6)], b = POLICIES[below(g, 0, 6)];
+            WhatIfParams prm;
+            prm.horizon     = double(below(g, 0, 20000));
+            prm.threshold   = below(g, 0, 2) == 0 ? double(below(g, 0, 5000)) : -1;
+            prm.extra_nodes = below(g, 0, 1);
+            prm.metric      = WhatIfMetric(below(g, 0, 2));
+            prm.budget      = UINT64_MAX;
+            const double want = naive_replay(*snap, p, b, prm);
+            CHECK(replay.run(p, b, prm) == want);
+
+            prm.budget = below(g, 0, 4000);
+            double got = replay.run(p, b, prm);
+            CHECK(std::isnan(got) || got == want);
+        }
+    }
+    return check::pass("what_if");
+}
@@ -0,0 +1,108 @@
+/**************************************************************
+ *  easy_live.cpp  —  tail the telemetry of a running plug-in
+ *                    ("#live", live_telemetry.hpp)
+ *
+ *      easy_live [-n NAME] [-i MS] [-a]
+ *
+ *  Every MS milliseconds (default 1000) prints the last sample
+ *  (simulated time, pending jobs, free hosts, jobs started and
+ *  backfilled) with the decision calls since the previous line
+ *  and their mean and max latency.  With -a every sample is
+ *  printed instead, as CSV.  Waits for the segment to appear,
+ *  and exits once the plug-in has closed it and it is drained,
+ *  or its process is gone.
+ *  Samples lost because the reader fell behind are reported.
+ *************************************************************/
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+
+#include <signal.h>
+#include <unistd.h>
+
+#include "live_telemetry.hpp"
+
+static void usage()
+{
+    fprintf(stderr, "usage: easy_live [-n NAME] [-i MS] [-a]\n"
+                    "  -n NAME  segment the plug-in writes (\"#live=NAME\"), default /easy-live\n"
+                    "  -i MS    print / poll period in milliseconds, default 1000\n"
+                    "  -a       every sample, as CSV\n");
+}
+
+int main(int argc, char** argv)
+{
+    std::string name = "/easy-live";
+    long period_ms = 1000;
+    bool all = false;
+    for (int c; (c = getopt(argc, argv, "n:i:ah")) != -1;) {
+        switch (c) {
+        case 'n': name = optarg; break;
+        case 'i': period_ms = std::max(1L, std::strtol(optarg, nullptr, 10)); break;
+        case 'a': all = true; break;
+        default:  usage(); return c == 'h' ? 0 : 2;
+        }
+    }
+    if (optind != argc) { usage(); return 2; }
+    if (all) period_ms = std::min(period_ms, 50L);   // drain often enough to keep up
+    const auto period = std::chrono::milliseconds(period_ms);
+
+    bool waiting = false;
+    for (;;) {
+        LiveReader r(name);
+        if (!r.ok()) {
+            if (!waiting)
+                fprintf(stderr, "easy_live: waiting for %s (%s)\n", name.c_str(), r.reason().c_str());
+            waiting = true;
+            std::this_thread::sleep_for(period);
+            continue;
+        }
+        fprintf(stderr, "easy_live: attached to %s (pid %" PRId64 ")\n", name.c_str(), r.pid());
+        if (all) printf("now,call,pending,free_hosts,started,backfilled,latency_ns\n");
+
+        LiveSample last{};
+        bool     seen = false;
+        uint64_t calls = 0, lat_sum = 0, lat_max = 0, lost_seen = 0;
+        bool more = true;
+        while (more) {
+            more = r.poll([&](const LiveSample& s) {
+                if (all)
+                    printf("%.17g,%" PRIu64 ",%u,%u,%" PRIu64 ",%" PRIu64 ",%" PRIu64 "\n",
+                           s.now, s.call, s.pending, s.free_hosts, s.started, s.backfilled,
+                           s.latency_ns);
+                ++calls;
+                lat_sum += s.latency_ns;
+                lat_max = std::max(lat_max, s.latency_ns);
+                last = s; seen = true;
+            });
+            if (r.lost() != lost_seen) {
+                fprintf(stderr, "easy_live: %" PRIu64 " samples lost (reader behind)\n",
+                        r.lost() - lost_seen);
+                lost_seen = r.lost();
+            }
+            if (!all && seen && calls) {
+                printf("t=%.0f s  call %" PRIu64 "  pending %u  free %u/%u  started %" PRIu64
+                       " (backfilled %" PRIu64 ")  calls %" PRIu64 "  latency mean %.1f us max %.1f us\n",
+                       last.now, last.call, last.pending, last.free_hosts, r.nb_hosts(),
+                       last.started, last.backfilled, calls,
+                       lat_sum / 1e3 / calls, lat_max / 1e3);
+                calls = lat_sum = lat_max = 0;
+            }
+            fflush(stdout);
+            if (more && kill(pid_t(r.pid()), 0) != 0 && errno == ESRCH) {
+                fprintf(stderr, "easy_live: the writer (pid %" PRId64 ") is gone\n", r.pid());
+                more = false;
+            }
+            if (more) std::this_thread::sleep_for(period);
+        }
+        fprintf(stderr, "easy_live: %s closed", name.c_str());
+        if (seen) fprintf(stderr, " at t=%.0f s after %" PRIu64 " calls", last.now, last.call);
+        fprintf(stderr, ", %" PRIu64 " samples lost\n", r.lost());
+        return 0;
+    }
+}